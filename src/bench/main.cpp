@@ -0,0 +1,583 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include <common/board.h>
+#include <common/board_batch.h>
+#include <common/byte_utils.h>
+#include <common/files.h>
+#include <common/level_data.h>
+#include <common/search.h>
+
+using namespace hexx::common;
+
+static std::atomic<uint64_t> allocation_count{0};
+static std::atomic<uint64_t> allocation_bytes{0};
+
+// GCC pairs the inlined free below with the call to operator new it came from, and doesn't know these are replaced
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// count every allocation of the program, benchmarks report the ones made while they run
+static void count_allocation(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size)
+{
+    count_allocation(size);
+
+    if (auto pointer = std::malloc(size ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    count_allocation(size);
+
+    const auto align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    if (auto pointer = _aligned_malloc(size ? size : 1, align))
+        return pointer;
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment
+    const auto rounded = ((size ? size : 1) + align - 1) / align * align;
+    if (auto pointer = std::aligned_alloc(align, rounded))
+        return pointer;
+#endif
+
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void operator delete[](void *pointer, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+/**
+ * @brief Results of the benchmarks are folded in here and reported, so the compiler can't drop the work.
+ */
+static uint64_t checksum = 0;
+
+/**
+ * @brief Settings of a benchmark run, taken from the command line.
+ */
+struct BenchOptions
+{
+    /**
+     * @brief File to write the JSON report to, stdout if empty.
+     */
+    std::string output{};
+
+    /**
+     * @brief Report of an earlier run to compare against, no comparison if empty.
+     */
+    std::string baseline{};
+
+    /**
+     * @brief Slowdown in percent above which a benchmark is flagged as a regression.
+     */
+    double threshold{10.0};
+
+    /**
+     * @brief Minimum measured time of every benchmark.
+     */
+    std::chrono::milliseconds min_time{250};
+
+    /**
+     * @brief Only benchmarks whose name contains this are run.
+     */
+    std::string filter{};
+};
+
+/**
+ * @brief Positions the benchmarks run over and the serialized form of each.
+ */
+struct Corpus
+{
+    std::vector<Board> positions;
+    std::vector<std::vector<uint8_t>> saves;
+};
+
+/**
+ * @brief A microbenchmark. The body runs on one position of the corpus and returns how many operations it did.
+ */
+struct Benchmark
+{
+    char const *name;
+    std::function<uint64_t(Board const &position, size_t index, Board &scratch)> body;
+};
+
+struct BenchResult
+{
+    std::string name;
+    double ns_per_op{0};
+    double allocs_per_op{0};
+    double bytes_per_op{0};
+    uint64_t ops{0};
+};
+
+/**
+ * @brief Positions seen in random games on the first level. The generator is seeded with a constant,
+ * so every run uses the same positions.
+ */
+static Corpus build_corpus(size_t size)
+{
+    Corpus corpus;
+    std::mt19937_64 gen{0x6865787861676F6EULL};
+
+    while (corpus.positions.size() < size)
+    {
+        Board board;
+        board.reset(HexMap<TileState>{LEVEL1_TEMPLATE});
+
+        while (!board.game_ended() && corpus.positions.size() < size)
+        {
+            MoveList<MAX_MOVES> moves;
+            board.generate_moves(moves);
+
+            if (moves.empty())
+                break;
+
+            const auto move = moves[gen() % moves.size()];
+            board.make_move(move.from, move.to);
+
+            // the player who moved plays again if the opponent is stuck, like in a real game
+            board.current_player = other_player(board.current_player);
+            board.next_player();
+
+            if (!board.game_ended())
+            {
+                corpus.positions.push_back(board);
+                corpus.saves.push_back(board.serialize());
+            }
+        }
+    }
+
+    return corpus;
+}
+
+/**
+ * @brief Plays one ply of 1024 games in lockstep, started from the corpus positions and restarted when
+ * they all finish. Every running game counts as an operation.
+ */
+static uint64_t batch_ply(Corpus const &corpus, bool greedy)
+{
+    static constexpr size_t GAMES = 1024;
+    static BoardBatch batch(corpus.positions.front(), GAMES);
+    static std::mt19937_64 gen{0x6261746368ULL};
+
+    batch.generate();
+    if (batch.running() == 0)
+    {
+        for (size_t i = 0; i < GAMES; i++)
+        {
+            batch.set(i, corpus.positions[i % corpus.positions.size()]);
+        }
+        batch.generate();
+    }
+
+    if (greedy)
+        batch.select_greedy(gen);
+    else
+        batch.select_random(gen);
+    batch.apply();
+
+    return batch.running();
+}
+
+static std::vector<Benchmark> make_benchmarks(Corpus const &corpus)
+{
+    return {
+        {"HexMap::at", [](Board const &position, size_t, Board &)
+         {
+             const auto &map = position.map;
+             for (int y = 0; y < map.get_height(); y++)
+             {
+                 for (int x = 0; x < map.get_width(); x++)
+                 {
+                     checksum += static_cast<uint64_t>(*map.at(x, y));
+                 }
+             }
+             return static_cast<uint64_t>(map.get_width() * map.get_height());
+         }},
+        {"HexMap::relative_cube", [](Board const &position, size_t, Board &)
+         {
+             uint64_t ops = 0;
+             for (auto tile = position.map.cbegin(); tile != position.map.cend(); tile++)
+             {
+                 for (const auto &[q, r, s] : RING1_DIRECTIONS)
+                 {
+                     checksum += tile.relative_cube(q, r, s) != position.map.cend();
+                     ops++;
+                 }
+             }
+             return ops;
+         }},
+        {"Board::get_possible_moves", [](Board const &position, size_t, Board &)
+         {
+             uint64_t ops = 0;
+             auto own = position.tiles_of(position.current_player);
+             while (own.any())
+             {
+                 const auto index = own.pop_lowest();
+                 checksum += position.get_possible_moves(index % position.map.get_width(), index / position.map.get_width()).size();
+                 ops++;
+             }
+             return ops;
+         }},
+        {"Board::try_move", [](Board const &position, size_t, Board &scratch)
+         {
+             MoveList<MAX_MOVES> moves;
+             position.generate_moves(moves);
+
+             // every move starts from the position again, the copy reuses the scratch board's storage
+             for (const auto &move : moves)
+             {
+                 scratch = position;
+                 const auto info = position.move_info(move);
+                 scratch.selected_tile = info.from;
+                 checksum += scratch.try_move(info.to.first, info.to.second);
+             }
+             return static_cast<uint64_t>(moves.size());
+         }},
+        {"Board::can_move", [](Board const &position, size_t, Board &)
+         {
+             checksum += position.can_move();
+             return uint64_t{1};
+         }},
+        {"Board::game_ended", [](Board const &position, size_t, Board &)
+         {
+             checksum += position.game_ended();
+             return uint64_t{1};
+         }},
+        {"Board::next_player", [](Board const &position, size_t, Board &scratch)
+         {
+             scratch = position;
+             scratch.next_player();
+             checksum += static_cast<uint64_t>(scratch.current_player);
+             return uint64_t{1};
+         }},
+        {"Search depth 3", [](Board const &position, size_t, Board &)
+         {
+             // one thread, no table, book or endgame solver, so the work only depends on the position
+             if (position.game_ended() || !position.any_move())
+                 return uint64_t{0};
+
+             Search search;
+             search.set_endgame_empties(0);
+             const auto result = search.run(position, SearchLimits{.depth = 3});
+             checksum += result.nodes + result.best_move.to;
+             return uint64_t{1};
+         }},
+        {"BoardBatch ply (random)", [&corpus](Board const &, size_t, Board &)
+         {
+             return batch_ply(corpus, false);
+         }},
+        {"BoardBatch ply (greedy)", [&corpus](Board const &, size_t, Board &)
+         {
+             return batch_ply(corpus, true);
+         }},
+        {"Board::serialize", [](Board const &position, size_t, Board &)
+         {
+             checksum += position.serialize().size();
+             return uint64_t{1};
+         }},
+        {"Board::deserialize", [&corpus](Board const &, size_t index, Board &scratch)
+         {
+             scratch.deserialize(corpus.saves[index]);
+             checksum += scratch.ruby_score;
+             return uint64_t{1};
+         }},
+        {"ByteWriter/ByteReader round trip", [](Board const &position, size_t, Board &)
+         {
+             ByteWriter writer;
+             writer.write_uint8(static_cast<uint8_t>(position.current_player))
+                 .write_uint16(position.ruby_score)
+                 .write_uint32(position.pearl_score)
+                 .write_uint64(position.hash())
+                 .write_int32(-position.get_empty_count())
+                 .write_string("hexxagon");
+
+             ByteReader reader(std::move(writer.data));
+             checksum += reader.read_uint8() + reader.read_uint16() + reader.read_uint32() + reader.read_uint64();
+             checksum += reader.read_int32() + reader.read_string().size();
+             return uint64_t{1};
+         }},
+    };
+}
+
+static BenchResult run_benchmark(Benchmark const &benchmark, Corpus const &corpus, BenchOptions const &options)
+{
+    Board scratch = corpus.positions.front();
+
+    const auto pass = [&](size_t count)
+    {
+        uint64_t ops = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            ops += benchmark.body(corpus.positions[i], i, scratch);
+        }
+        return ops;
+    };
+
+    const auto count = corpus.positions.size();
+
+    // warm caches and let the scratch board grow to its final size before anything is counted
+    pass(count);
+
+    const auto allocations_before = allocation_count.load();
+    const auto bytes_before = allocation_bytes.load();
+    const auto start = std::chrono::steady_clock::now();
+
+    uint64_t ops = 0;
+    std::chrono::steady_clock::duration elapsed{};
+
+    do
+    {
+        ops += pass(count);
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < options.min_time);
+
+    BenchResult result{.name = benchmark.name, .ops = ops};
+    if (ops > 0)
+    {
+        result.ns_per_op = std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+        result.allocs_per_op = static_cast<double>(allocation_count.load() - allocations_before) / ops;
+        result.bytes_per_op = static_cast<double>(allocation_bytes.load() - bytes_before) / ops;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Reads the benchmarks of a report written by this program, one per line.
+ */
+static std::vector<BenchResult> read_report(std::string const &path)
+{
+    const auto data = read_file(path);
+    const std::string text(data.begin(), data.end());
+
+    std::vector<BenchResult> results;
+    size_t line_start = 0;
+
+    while (line_start < text.size())
+    {
+        auto line_end = text.find('\n', line_start);
+        if (line_end == std::string::npos)
+            line_end = text.size();
+
+        const auto line = text.substr(line_start, line_end - line_start);
+        line_start = line_end + 1;
+
+        char name[128];
+        BenchResult result;
+        if (std::sscanf(line.c_str(), " {\"name\": \"%127[^\"]\", \"ns_per_op\": %lf, \"allocs_per_op\": %lf, \"bytes_per_op\": %lf",
+                        name, &result.ns_per_op, &result.allocs_per_op, &result.bytes_per_op) == 4)
+        {
+            result.name = name;
+            results.push_back(result);
+        }
+    }
+
+    return results;
+}
+
+static void print_usage(char const *program)
+{
+    printf("Usage: %s [-o report.json] [-c baseline.json] [-t percent] [-m ms] [-f filter]\n", program);
+    printf("  -o report.json    write the JSON report to a file instead of stdout\n");
+    printf("  -c baseline.json  compare with an earlier report and exit with 1 on regressions\n");
+    printf("  -t percent        slowdown flagged as a regression, default 10\n");
+    printf("  -m ms             minimum time of every benchmark, default 250\n");
+    printf("  -f filter         only run benchmarks whose name contains filter\n");
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (arg == "-o")
+            options.output = argv[++i];
+        else if (arg == "-c")
+            options.baseline = argv[++i];
+        else if (arg == "-t")
+            options.threshold = std::atof(argv[++i]);
+        else if (arg == "-m")
+            options.min_time = std::chrono::milliseconds{std::atoi(argv[++i])};
+        else if (arg == "-f")
+            options.filter = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> baseline;
+    if (!options.baseline.empty())
+    {
+        try
+        {
+            baseline = read_report(options.baseline);
+        }
+        catch (std::exception const &e)
+        {
+            fprintf(stderr, "Error reading baseline: %s\n", e.what());
+            return 1;
+        }
+    }
+
+    const auto corpus = build_corpus(64);
+    const auto benchmarks = make_benchmarks(corpus);
+
+    std::string report = "{\n";
+    report += "  \"corpus\": " + std::to_string(corpus.positions.size()) + ",\n";
+    report += "  \"benchmarks\": [\n";
+
+    int regressions = 0;
+    bool first = true;
+
+    for (const auto &benchmark : benchmarks)
+    {
+        if (std::string(benchmark.name).find(options.filter) == std::string::npos)
+            continue;
+
+        const auto result = run_benchmark(benchmark, corpus, options);
+        fprintf(stderr, "%-34s %12.1f ns/op %8.2f allocs/op %10.1f bytes/op\n", result.name.c_str(), result.ns_per_op,
+                result.allocs_per_op, result.bytes_per_op);
+
+        char line[512];
+        snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.3f, \"ops\": %llu",
+                 result.name.c_str(), result.ns_per_op, result.allocs_per_op, result.bytes_per_op,
+                 static_cast<unsigned long long>(result.ops));
+
+        report += first ? "" : ",\n";
+        report += line;
+        first = false;
+
+        const auto base = std::ranges::find(baseline, result.name, &BenchResult::name);
+        if (base != baseline.end())
+        {
+            const auto factor = 1.0 + options.threshold / 100.0;
+            const auto change = base->ns_per_op > 0 ? (result.ns_per_op / base->ns_per_op - 1.0) * 100.0 : 0.0;
+            const auto regression = result.ns_per_op > base->ns_per_op * factor ||
+                                    result.allocs_per_op > base->allocs_per_op * factor + 0.01;
+
+            if (regression)
+            {
+                regressions++;
+                fprintf(stderr, "  regression: %.1f ns/op (%+.1f%%), %.2f allocs/op, baseline %.1f ns/op, %.2f allocs/op\n",
+                        result.ns_per_op, change, result.allocs_per_op, base->ns_per_op, base->allocs_per_op);
+            }
+
+            snprintf(line, sizeof(line), ", \"baseline_ns_per_op\": %.3f, \"change_percent\": %.1f, \"regression\": %s",
+                     base->ns_per_op, change, regression ? "true" : "false");
+            report += line;
+        }
+
+        report += "}";
+    }
+
+    report += "\n  ],\n";
+    if (!options.baseline.empty())
+        report += "  \"regressions\": " + std::to_string(regressions) + ",\n";
+    report += "  \"checksum\": " + std::to_string(checksum) + "\n";
+    report += "}\n";
+
+    if (options.output.empty())
+    {
+        printf("%s", report.c_str());
+    }
+    else
+    {
+        try
+        {
+            write_file(options.output, std::vector<uint8_t>(report.begin(), report.end()));
+        }
+        catch (std::exception const &e)
+        {
+            fprintf(stderr, "Error writing report: %s\n", e.what());
+            return 1;
+        }
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,264 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <common/board.h>
+#include <common/files.h>
+#include <common/level_data.h>
+#include <common/opening_book.h>
+#include <common/search.h>
+
+using namespace hexx::common;
+
+/**
+ * @brief Settings of a book build, taken from the command line.
+ */
+struct BuildOptions
+{
+    std::string output{DEFAULT_BOOK_PATH};
+
+    /**
+     * @brief Number of plies from the start position covered by the book.
+     */
+    int plies{6};
+
+    /**
+     * @brief Search depth used to score every move, counting the move itself.
+     */
+    int depth{4};
+
+    /**
+     * @brief Moves scoring at most this much below the best one are kept, with lower weights.
+     * At most MAX_MARGIN, so the weight of the best move still fits in a u16.
+     */
+    int margin{0};
+
+    static constexpr int MAX_MARGIN = UINT16_MAX - 1;
+};
+
+/**
+ * @brief Walks the opening tree of LEVEL1_TEMPLATE, scores every move of every position with a search
+ * and keeps the good ones as book moves. Only positions reachable through book moves are expanded.
+ */
+class BookBuilder
+{
+    BuildOptions options;
+    Search search;
+    /**
+     * @brief A position already scored: the smallest ply it was reached at and its book moves in entries.
+     */
+    struct Visit
+    {
+        int ply;
+        size_t first_entry;
+        size_t entry_count;
+    };
+
+    std::unordered_map<uint64_t, Visit> visited;
+    std::vector<BookEntry> entries;
+
+    /**
+     * @brief Score of a move for the player making it.
+     */
+    int score_move(Board const &board, Move const &move)
+    {
+        const SearchLimits limits{.depth = std::max(options.depth - 1, 1)};
+
+        Board child = board;
+        child.make_move(move.from, move.to);
+
+        if (child.game_ended())
+            return -Search::terminal_score(child, 1);
+
+        if (child.any_move())
+            return -search.run(child, limits).score;
+
+        // the opponent has to pass and the same player moves again
+        child.current_player = other_player(child.current_player);
+
+        if (!child.any_move())
+            return Search::terminal_score(child, 1);
+
+        return search.run(child, limits).score;
+    }
+
+    /**
+     * @brief Expands the position a book move leads to.
+     */
+    void expand_move(Board const &board, Move const &move, int ply)
+    {
+        Board child = board;
+        child.make_move(move.from, move.to);
+
+        // mirror Board::next_player, the book is probed with the player who actually moves next
+        if (!child.game_ended() && !child.any_move())
+        {
+            child.current_player = other_player(child.current_player);
+        }
+
+        expand(child, ply + 1);
+    }
+
+    /**
+     * @brief Scores the moves of a position reached at a ply and expands the book moves. A position reached
+     * again at a smaller ply keeps its entries, but its book moves are expanded again with more plies left, so
+     * the book doesn't depend on the order positions are visited in.
+     */
+    void expand(Board const &board, int ply)
+    {
+        if (ply >= options.plies || board.game_ended())
+            return;
+
+        if (const auto found = visited.find(board.hash()); found != visited.end())
+        {
+            if (found->second.ply <= ply)
+                return;
+
+            found->second.ply = ply;
+
+            // copied, entries grows while the children are expanded
+            std::vector<Move> book_moves;
+            for (size_t i = 0; i < found->second.entry_count; i++)
+            {
+                book_moves.push_back(entries[found->second.first_entry + i].move);
+            }
+
+            for (const auto &move : book_moves)
+            {
+                expand_move(board, move, ply);
+            }
+
+            return;
+        }
+
+        auto &visit = visited[board.hash()];
+        visit = {.ply = ply, .first_entry = entries.size(), .entry_count = 0};
+
+        MoveList<MAX_MOVES> moves;
+        board.generate_moves(moves);
+
+        if (moves.empty())
+            return;
+
+        std::vector<int> scores;
+        for (const auto &move : moves)
+        {
+            scores.push_back(score_move(board, move));
+        }
+
+        const auto best = *std::ranges::max_element(scores);
+
+        for (size_t i = 0; i < moves.size(); i++)
+        {
+            const auto behind = best - scores[i];
+            if (behind > options.margin)
+                continue;
+
+            entries.push_back({
+                .key = board.hash(),
+                .move = moves[i],
+                .weight = static_cast<uint16_t>(options.margin + 1 - behind),
+                .score = static_cast<int16_t>(std::clamp(scores[i], INT16_MIN, INT16_MAX)),
+            });
+        }
+
+        visit.entry_count = entries.size() - visit.first_entry;
+
+        printf("\r%zu positions, %zu book moves", visited.size(), entries.size());
+        fflush(stdout);
+
+        for (size_t i = 0; i < moves.size(); i++)
+        {
+            if (best - scores[i] <= options.margin)
+                expand_move(board, moves[i], ply);
+        }
+    }
+
+public:
+    explicit BookBuilder(BuildOptions options) : options(std::move(options))
+    {
+        search.set_transposition_table(std::make_shared<TranspositionTable>(64));
+    }
+
+    /**
+     * @brief Builds the book and writes it to the output file.
+     */
+    void build()
+    {
+        Board board;
+        board.reset(HexMap<TileState>{LEVEL1_TEMPLATE});
+
+        expand(board, 0);
+
+        write_file(options.output, OpeningBook::serialize(entries));
+        printf("\nWrote %zu book moves for %zu positions to '%s'.\n", entries.size(), visited.size(), options.output.c_str());
+    }
+};
+
+static void print_usage(char const *program)
+{
+    printf("Usage: %s [output] [plies] [depth] [margin]\n", program);
+    printf("  output  book file to write, default %s\n", DEFAULT_BOOK_PATH);
+    printf("  plies   plies from the start position covered by the book, at least 1, default 6\n");
+    printf("  depth   search depth used to score moves, 1 to %d, default 4\n", MAX_PLY - 1);
+    printf("  margin  keep moves scoring at most this much below the best one, at most %d, default 0\n",
+           BuildOptions::MAX_MARGIN);
+}
+
+/**
+ * @brief Parses a whole number argument.
+ *
+ * @return bool false if the argument isn't a number from min to max
+ */
+static bool parse_number(char const *text, int min, int max, int &value)
+{
+    char *end = nullptr;
+    const auto number = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || number < min || number > max)
+        return false;
+
+    value = static_cast<int>(number);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 5 || (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    BuildOptions options;
+    if (argc > 1)
+        options.output = argv[1];
+
+    if ((argc > 2 && !parse_number(argv[2], 1, INT_MAX, options.plies)) ||
+        (argc > 3 && !parse_number(argv[3], 1, MAX_PLY - 1, options.depth)) ||
+        (argc > 4 && !parse_number(argv[4], 0, INT_MAX, options.margin)))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // a larger margin would overflow the weights, and this one already keeps almost every move
+    options.margin = std::min(options.margin, BuildOptions::MAX_MARGIN);
+
+    try
+    {
+        BookBuilder{options}.build();
+    }
+    catch (std::exception const &e)
+    {
+        printf("\nError building the book: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
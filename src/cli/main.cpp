@@ -5,6 +5,7 @@
 #include <numeric>
 #include <algorithm>
 
+#include <common/ai_worker.h>
 #include <common/board.h>
 #include <common/level_data.h>
 #include <common/highscore_manager.h>
@@ -264,8 +265,41 @@ std::pair<int, int> prompt_tile_highlighted(Board const &board)
  */
 void game_loop(Board &board)
 {
+    AiWorker ai{};
+
     for (;;)
     {
+        // checked before anyone moves, a loaded game may already be over
+        if (board.game_ended() || board.no_moves_left())
+        {
+            board.clear_highlights();
+            print_board(board);
+            printf("Game over!\n");
+
+            if (board.ruby_score > board.pearl_score)
+            {
+                printf("Ruby won!\n");
+            }
+            else if (board.ruby_score < board.pearl_score)
+            {
+                printf("Pearl won!\n");
+            }
+            else
+            {
+                printf("It's a draw!\n");
+            }
+
+            HighScoreManager{}.add_score(board.ruby_score, board.pearl_score);
+
+            break;
+        }
+
+        // a loaded game may leave the turn with a player who can't move, the other one can
+        if (!board.any_move())
+        {
+            board.current_player = other_player(board.current_player);
+        }
+
         printf("This is %s%s%s's turn!\n",
                board.current_player == Player::Ruby ? Ansi{}.bold().red().c_str() : Ansi{}.bold().white().c_str(),
                board.current_player == Player::Ruby ? "Ruby" : "Pearl",
@@ -277,7 +311,20 @@ void game_loop(Board &board)
 
             print_board(board);
 
-            const auto move = board.ai_play();
+            ai.request(board);
+
+            AiResult result{};
+            try
+            {
+                result = ai.wait();
+            }
+            catch (std::exception const &e)
+            {
+                printf("The computer couldn't move: %s\n", e.what());
+                break;
+            }
+
+            const auto &move = result.move;
 
             board.selected_tile = move.from;
             const auto [to_x, to_y] = move.to;
@@ -287,6 +334,12 @@ void game_loop(Board &board)
             if (board.try_move(to_x, to_y))
             {
                 board.next_player();
+
+                // keep thinking while the player does, expecting the reply the search predicted
+                if (board.current_player == Player::Ruby && !board.game_ended())
+                {
+                    ai.ponder(board, result.search.pv.size() > 1 ? std::optional{result.search.pv[1]} : std::nullopt);
+                }
             }
         }
         else
@@ -304,30 +357,6 @@ void game_loop(Board &board)
                 board.next_player();
             }
         }
-
-        if (board.game_ended())
-        {
-            board.clear_highlights();
-            print_board(board);
-            printf("Game over!\n");
-
-            if (board.ruby_score > board.pearl_score)
-            {
-                printf("Ruby won!\n");
-            }
-            else if (board.ruby_score < board.pearl_score)
-            {
-                printf("Pearl won!\n");
-            }
-            else
-            {
-                printf("It's a draw!\n");
-            }
-
-            HighScoreManager{}.add_score(board.ruby_score, board.pearl_score);
-
-            break;
-        }
     }
 }
 
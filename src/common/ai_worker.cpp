@@ -0,0 +1,225 @@
+#include "ai_worker.h"
+
+#include <algorithm>
+
+using namespace hexx::common;
+
+AiWorker::AiWorker(SearchLimits limits, int threads, std::shared_ptr<const OpeningBook> book)
+    : limits(limits), threads(threads != 0 ? threads : static_cast<int>(std::thread::hardware_concurrency())), book(std::move(book))
+{
+    thread = std::thread([this]()
+                         { loop(); });
+}
+
+AiWorker::~AiWorker()
+{
+    {
+        std::lock_guard lock(mutex);
+        shutdown = true;
+        cancel_locked();
+    }
+
+    wake.notify_one();
+    thread.join();
+}
+
+void AiWorker::loop()
+{
+    std::unique_lock lock(mutex);
+
+    for (;;)
+    {
+        wake.wait(lock, [this]()
+                  { return shutdown || pending.has_value(); });
+
+        if (shutdown)
+            return;
+
+        auto request = std::move(*pending);
+        pending.reset();
+
+        auto request_limits = limits;
+        request_limits.ponder = request.ponder;
+
+        // a fresh search per request: a stop() from cancel() can't leak into the next one
+        Search search;
+        search.set_transposition_table(table);
+        search.set_threads(threads);
+
+        active = &search;
+        running_ticket = request.ticket;
+        lock.unlock();
+
+        Completion completion{.result = {.ticket = request.ticket, .move = {}, .search = {}}, .error = nullptr};
+
+        try
+        {
+            const auto book_move = book ? book->choose(request.board, book_gen) : std::nullopt;
+
+            completion.result.search = book_move ? SearchResult{.best_move = *book_move, .pv = {*book_move}}
+                                                 : search.run(request.board, request_limits);
+            completion.result.move = request.board.move_info(completion.result.search.best_move);
+        }
+        catch (...)
+        {
+            completion.error = std::current_exception();
+        }
+
+        lock.lock();
+        active = nullptr;
+        running_ticket = 0;
+
+        if (request.ticket == current_ticket)
+        {
+            // a ponder search that ran out of depth before the opponent moved, keep it until request() asks
+            if (request.ticket == ponder_ticket)
+            {
+                ponder_completion = std::move(completion);
+            }
+            else
+            {
+                completed.push_back(std::move(completion));
+                finished.notify_all();
+            }
+        }
+    }
+}
+
+void AiWorker::cancel_locked()
+{
+    current_ticket++;
+    pending.reset();
+    completed.clear();
+    ponder_ticket = 0;
+    ponder_completion.reset();
+
+    if (active)
+    {
+        active->stop();
+    }
+}
+
+uint64_t AiWorker::request(Board const &board)
+{
+    uint64_t ticket;
+
+    {
+        std::lock_guard lock(mutex);
+
+        // ponderhit: the opponent played the expected move, the running search becomes the answer
+        if (ponder_ticket != 0 && board.hash() == ponder_hash)
+        {
+            ponder_ticket = 0;
+
+            if (ponder_completion)
+            {
+                completed.push_back(std::move(*ponder_completion));
+                ponder_completion.reset();
+                finished.notify_all();
+            }
+            else if (pending)
+            {
+                pending->ponder = false;
+            }
+            else if (active)
+            {
+                active->ponderhit();
+            }
+
+            return current_ticket;
+        }
+
+        cancel_locked();
+
+        ticket = current_ticket;
+        pending = Request{.ticket = ticket, .board = board, .ponder = false};
+    }
+
+    wake.notify_one();
+    return ticket;
+}
+
+void AiWorker::ponder(Board const &board, std::optional<Move> const &expected)
+{
+    Board position = board;
+
+    if (expected)
+    {
+        MoveList<MAX_MOVES> moves;
+        position.generate_moves(moves);
+
+        if (std::find(moves.begin(), moves.end(), *expected) != moves.end())
+        {
+            position.make_move(expected->from, expected->to);
+
+            // the opponent's reply would make us pass, nothing to speculate on
+            if (!position.any_move())
+            {
+                position = board;
+            }
+        }
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        cancel_locked();
+
+        if (!position.any_move())
+            return;
+
+        ponder_ticket = current_ticket;
+        ponder_hash = position.hash();
+        pending = Request{.ticket = current_ticket, .board = std::move(position), .ponder = true};
+    }
+
+    wake.notify_one();
+}
+
+AiResult AiWorker::take_locked()
+{
+    auto completion = std::move(completed.front());
+    completed.pop_front();
+
+    if (completion.error)
+    {
+        std::rethrow_exception(completion.error);
+    }
+
+    return completion.result;
+}
+
+std::optional<AiResult> AiWorker::poll()
+{
+    std::lock_guard lock(mutex);
+
+    if (completed.empty())
+        return std::nullopt;
+
+    return take_locked();
+}
+
+AiResult AiWorker::wait()
+{
+    std::unique_lock lock(mutex);
+    finished.wait(lock, [this]()
+                  { return !completed.empty(); });
+
+    return take_locked();
+}
+
+void AiWorker::cancel()
+{
+    std::lock_guard lock(mutex);
+    cancel_locked();
+}
+
+bool AiWorker::busy()
+{
+    std::lock_guard lock(mutex);
+
+    // a cancelled search may still be winding down and pondering isn't working on a request, neither counts
+    if (ponder_ticket != 0)
+        return false;
+
+    return pending.has_value() || !completed.empty() || (running_ticket != 0 && running_ticket == current_ticket);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "board.h"
+#include "opening_book.h"
+#include "search.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+
+namespace hexx::common
+{
+    /**
+     * @brief A move chosen by the AiWorker.
+     */
+    struct AiResult
+    {
+        /**
+         * @brief Ticket returned by the AiWorker::request call this result answers.
+         */
+        uint64_t ticket;
+        MoveInfo move;
+        SearchResult search;
+    };
+
+    /**
+     * @brief Runs the computer player on a background thread, so the caller never waits for it to think.
+     *
+     * The caller hands over a copy of the position with request() and then keeps calling poll()
+     * until the move arrives. Only one request is worked on at a time: a new request or cancel()
+     * stops the current search and drops its result.
+     *
+     * While the opponent thinks, ponder() keeps the thread busy on the move it expects them to play.
+     * If they do, the next request() takes over that search and answers almost at once. If they play
+     * something else, the transposition table kept between searches still holds the work that applies.
+     */
+    class AiWorker
+    {
+        struct Request
+        {
+            uint64_t ticket;
+            Board board;
+            bool ponder;
+        };
+
+        struct Completion
+        {
+            AiResult result;
+            std::exception_ptr error;
+        };
+
+        SearchLimits limits;
+        int threads;
+        std::shared_ptr<TranspositionTable> table{std::make_shared<TranspositionTable>()};
+        std::shared_ptr<const OpeningBook> book;
+        std::mt19937_64 book_gen{std::random_device{}()};
+
+        std::mutex mutex{};
+        std::condition_variable wake{};
+        std::condition_variable finished{};
+        std::optional<Request> pending{};
+        std::deque<Completion> completed{};
+
+        /**
+         * @brief Ticket of the ponder search not confirmed by request() yet, 0 if there's none.
+         */
+        uint64_t ponder_ticket{0};
+
+        /**
+         * @brief Hash of the position the ponder search expects to be asked about.
+         */
+        uint64_t ponder_hash{0};
+
+        /**
+         * @brief Result of a ponder search that finished before request() confirmed it.
+         */
+        std::optional<Completion> ponder_completion{};
+        Search *active{nullptr};
+        uint64_t current_ticket{0};
+
+        /**
+         * @brief Ticket of the request being searched, 0 if the thread is idle. Tickets start at 1.
+         */
+        uint64_t running_ticket{0};
+        bool shutdown{false};
+        std::thread thread{};
+
+        void loop();
+
+        void cancel_locked();
+
+        AiResult take_locked();
+
+    public:
+        /**
+         * @param limits limits of every search
+         * @param threads number of search threads, 0 for one per hardware thread
+         * @param book opening book, positions found in it are answered without searching. Null disables it.
+         */
+        explicit AiWorker(SearchLimits limits = AI_SEARCH_LIMITS, int threads = 0,
+                          std::shared_ptr<const OpeningBook> book = OpeningBook::open_default());
+
+        AiWorker(AiWorker const &) = delete;
+
+        AiWorker &operator=(AiWorker const &) = delete;
+
+        /**
+         * @brief Cancels the current search and waits for the thread to finish.
+         */
+        ~AiWorker();
+
+        /**
+         * @brief Starts looking for a move of the player to move. Cancels the previous request.
+         *
+         * @param board position to search, copied
+         * @return uint64_t ticket identifying the result
+         */
+        uint64_t request(Board const &board);
+
+        /**
+         * @brief Starts searching on the opponent's time. Cancels the previous request.
+         *
+         * @param board position with the opponent to move, copied
+         * @param expected the opponent's move to speculate on, usually the second move of the last principal variation.
+         * Without it, or if it isn't legal, the search runs on the opponent's position to fill the transposition table.
+         */
+        void ponder(Board const &board, std::optional<Move> const &expected);
+
+        /**
+         * @brief Takes the result of the latest request if it's ready. Never blocks.
+         *
+         * @return std::optional<AiResult> the result, or nothing if the search is still running
+         * @throws runtime_error if the game was over or the player to move had no moves.
+         */
+        std::optional<AiResult> poll();
+
+        /**
+         * @brief Waits for the result of the latest request. Must only be called after request().
+         *
+         * @return AiResult the result
+         * @throws runtime_error if the game was over or the player to move had no moves.
+         */
+        AiResult wait();
+
+        /**
+         * @brief Stops the current search, pondering included, and drops any result that hasn't been polled yet.
+         */
+        void cancel();
+
+        /**
+         * @return true if a request is being searched or its result waits to be polled.
+         */
+        bool busy();
+    };
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include "hexmap.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+namespace hexx::common
+{
+    /**
+     * @brief A 128-bit set of tiles, one bit per flat tile index (y * width + x).
+     */
+    class Bitboard
+    {
+        uint64_t lo{0};
+        uint64_t hi{0};
+
+    public:
+        static constexpr int CAPACITY = 128;
+
+        constexpr Bitboard() {}
+        constexpr Bitboard(uint64_t lo, uint64_t hi) : lo(lo), hi(hi) {}
+
+        /**
+         * @brief Returns a bitboard with only the specified bit set.
+         *
+         * @param index flat tile index
+         */
+        static constexpr Bitboard bit(int index)
+        {
+            return index < 64 ? Bitboard{1ULL << index, 0} : Bitboard{0, 1ULL << (index - 64)};
+        }
+
+        constexpr uint64_t low_word() const
+        {
+            return lo;
+        }
+
+        constexpr uint64_t high_word() const
+        {
+            return hi;
+        }
+
+        constexpr bool test(int index) const
+        {
+            return index < 64 ? (lo >> index) & 1 : (hi >> (index - 64)) & 1;
+        }
+
+        constexpr void set(int index)
+        {
+            *this |= bit(index);
+        }
+
+        constexpr void reset(int index)
+        {
+            *this &= ~bit(index);
+        }
+
+        constexpr bool any() const
+        {
+            return (lo | hi) != 0;
+        }
+
+        constexpr bool none() const
+        {
+            return (lo | hi) == 0;
+        }
+
+        /**
+         * @return int number of set bits.
+         */
+        constexpr int count() const
+        {
+            return std::popcount(lo) + std::popcount(hi);
+        }
+
+        /**
+         * @return int index of the lowest set bit. The bitboard must not be empty.
+         */
+        constexpr int lowest() const
+        {
+            return lo != 0 ? std::countr_zero(lo) : 64 + std::countr_zero(hi);
+        }
+
+        /**
+         * @brief Clears the lowest set bit and returns its index. The bitboard must not be empty.
+         */
+        constexpr int pop_lowest()
+        {
+            const auto index = lowest();
+            if (lo != 0)
+                lo &= lo - 1;
+            else
+                hi &= hi - 1;
+            return index;
+        }
+
+        /**
+         * @brief Shifts all bits towards higher indices by delta (or towards lower indices if delta is negative).
+         * Bits shifted past either end are discarded.
+         */
+        constexpr Bitboard shifted(int delta) const
+        {
+            if (delta >= 0)
+            {
+                if (delta == 0)
+                    return *this;
+                if (delta >= 128)
+                    return {};
+                if (delta >= 64)
+                    return {0, lo << (delta - 64)};
+                return {lo << delta, (hi << delta) | (lo >> (64 - delta))};
+            }
+
+            delta = -delta;
+            if (delta >= 128)
+                return {};
+            if (delta >= 64)
+                return {hi >> (delta - 64), 0};
+            return {(lo >> delta) | (hi << (64 - delta)), hi >> delta};
+        }
+
+        constexpr Bitboard operator~() const
+        {
+            return {~lo, ~hi};
+        }
+
+        constexpr Bitboard &operator&=(Bitboard const &other)
+        {
+            lo &= other.lo;
+            hi &= other.hi;
+            return *this;
+        }
+
+        constexpr Bitboard &operator|=(Bitboard const &other)
+        {
+            lo |= other.lo;
+            hi |= other.hi;
+            return *this;
+        }
+
+        constexpr Bitboard &operator^=(Bitboard const &other)
+        {
+            lo ^= other.lo;
+            hi ^= other.hi;
+            return *this;
+        }
+
+        friend constexpr Bitboard operator&(Bitboard a, Bitboard const &b)
+        {
+            return a &= b;
+        }
+
+        friend constexpr Bitboard operator|(Bitboard a, Bitboard const &b)
+        {
+            return a |= b;
+        }
+
+        friend constexpr Bitboard operator^(Bitboard a, Bitboard const &b)
+        {
+            return a ^= b;
+        }
+
+        friend constexpr bool operator==(Bitboard const &a, Bitboard const &b) = default;
+    };
+
+    /**
+     * @brief Precomputed geometry of a board of given size, used to compute neighbourhoods of whole bitboards with shifts.
+     *
+     * In the odd-q layout the flat index offset of a neighbour depends on the parity of the source column,
+     * so every direction has a shift amount and a mask of valid source tiles for even and for odd columns.
+     */
+    class BoardLayout
+    {
+    public:
+        struct Shift
+        {
+            /**
+             * @brief Flat index offset to the neighbour in this direction.
+             */
+            int delta;
+
+            /**
+             * @brief Tiles of this column parity whose neighbour in this direction is within bounds.
+             */
+            Bitboard sources;
+        };
+
+    private:
+        int width{};
+        int height{};
+        Bitboard tiles{};
+        std::array<std::array<Shift, 2>, 6> ring1_shifts{};
+        std::array<std::array<Shift, 2>, 12> ring2_shifts{};
+        std::array<Bitboard, Bitboard::CAPACITY> ring1_masks{};
+        std::array<Bitboard, Bitboard::CAPACITY> ring2_masks{};
+
+        template <size_t N>
+        static Bitboard spread(Bitboard const &from, std::array<std::array<Shift, 2>, N> const &shifts)
+        {
+            Bitboard result{};
+            for (auto const &by_parity : shifts)
+            {
+                for (auto const &shift : by_parity)
+                {
+                    result |= (from & shift.sources).shifted(shift.delta);
+                }
+            }
+            return result;
+        }
+
+        template <size_t N>
+        void build_shifts(std::array<std::tuple<int, int, int>, N> const &directions, std::array<std::array<Shift, 2>, N> &shifts)
+        {
+            for (size_t d = 0; d < N; d++)
+            {
+                const auto [dq, dr, ds] = directions[d];
+
+                for (int parity = 0; parity < 2; parity++)
+                {
+                    auto [q, r, s] = oddq_to_cube(parity, 0);
+                    auto [dx, dy] = cube_to_oddq(q + dq, r + dr, s + ds);
+                    dx -= parity;
+
+                    auto &shift = shifts[d][parity];
+                    shift.delta = dy * width + dx;
+
+                    for (int y = 0; y < height; y++)
+                    {
+                        for (int x = parity; x < width; x += 2)
+                        {
+                            if (x + dx >= 0 && x + dx < width && y + dy >= 0 && y + dy < height)
+                            {
+                                shift.sources.set(y * width + x);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Builds the layout for a board of specified dimensions.
+         *
+         * @throws invalid_argument if the board has more than 128 tiles.
+         */
+        BoardLayout(int width, int height) : width(width), height(height)
+        {
+            if (width <= 0 || height <= 0 || width * height > Bitboard::CAPACITY)
+            {
+                throw std::invalid_argument("board dimensions must be positive and cover at most 128 tiles");
+            }
+
+            for (int i = 0; i < width * height; i++)
+            {
+                tiles.set(i);
+            }
+
+            build_shifts(RING1_DIRECTIONS, ring1_shifts);
+            build_shifts(RING2_DIRECTIONS, ring2_shifts);
+
+            for (int i = 0; i < width * height; i++)
+            {
+                ring1_masks[i] = ring1(Bitboard::bit(i));
+                ring2_masks[i] = ring2(Bitboard::bit(i));
+            }
+        }
+
+        int get_width() const
+        {
+            return width;
+        }
+
+        int get_height() const
+        {
+            return height;
+        }
+
+        /**
+         * @return Bitboard all in-bounds tiles, including void ones.
+         */
+        Bitboard const &all_tiles() const
+        {
+            return tiles;
+        }
+
+        /**
+         * @return shifts of the six directions at distance 1, by column parity.
+         */
+        std::array<std::array<Shift, 2>, 6> const &get_ring1_shifts() const
+        {
+            return ring1_shifts;
+        }
+
+        /**
+         * @return shifts of the twelve directions at distance 2, by column parity.
+         */
+        std::array<std::array<Shift, 2>, 12> const &get_ring2_shifts() const
+        {
+            return ring2_shifts;
+        }
+
+        /**
+         * @return Bitboard tiles one step away in the direction RING1_DIRECTIONS[direction] from any tile in the set.
+         */
+        Bitboard step(Bitboard const &from, int direction) const
+        {
+            const auto &[even, odd] = ring1_shifts[direction];
+            return (from & even.sources).shifted(even.delta) | (from & odd.sources).shifted(odd.delta);
+        }
+
+        /**
+         * @return Bitboard tiles at distance 1 from any tile in the set.
+         */
+        Bitboard ring1(Bitboard const &from) const
+        {
+            return spread(from, ring1_shifts);
+        }
+
+        /**
+         * @return Bitboard tiles at distance 2 from any tile in the set.
+         */
+        Bitboard ring2(Bitboard const &from) const
+        {
+            return spread(from, ring2_shifts);
+        }
+
+        /**
+         * @return Bitboard tiles at distance 1 from the specified tile.
+         */
+        Bitboard const &ring1(int index) const
+        {
+            return ring1_masks[index];
+        }
+
+        /**
+         * @return Bitboard tiles at distance 2 from the specified tile.
+         */
+        Bitboard const &ring2(int index) const
+        {
+            return ring2_masks[index];
+        }
+    };
+}
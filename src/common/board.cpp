@@ -1,104 +1,220 @@
 #include "board.h"
-#include "rng.h"
+#include "search.h"
+#include "opening_book.h"
 #include "byte_utils.h"
 
+#include <bit>
 #include <ranges>
 #include <algorithm>
 #include <array>
+#include <random>
+#include <thread>
 #include <tuple>
 
 using namespace hexx::common;
 
 void Board::update_score()
 {
-    ruby_score = 0;
-    pearl_score = 0;
+    ruby_score = ruby_tiles.count();
+    pearl_score = pearl_tiles.count();
+    empty_count = empty_tiles.count();
+}
+
+void Board::sync_bitboards()
+{
+    if (!layout || layout->get_width() != map.get_width() || layout->get_height() != map.get_height())
+    {
+        layout = std::make_shared<const BoardLayout>(map.get_width(), map.get_height());
+    }
+
+    map.build_adjacency();
+
+    ruby_tiles = {};
+    pearl_tiles = {};
+    empty_tiles = {};
+    void_tiles = {};
+    tiles_hash = 0;
+    reach_counts = {};
 
     for (auto tile = map.cbegin(); tile != map.cend(); tile++)
     {
-        if (*tile == TileState::Ruby)
-        {
-            ruby_score++;
-        }
-        else if (*tile == TileState::Pearl)
+        tiles_hash ^= ZOBRIST_KEYS.tiles[tile.index()][static_cast<int>(*tile)];
+
+        switch (*tile)
         {
-            pearl_score++;
+        case TileState::Void:
+            void_tiles.set(tile.index());
+            break;
+        case TileState::Empty:
+            empty_tiles.set(tile.index());
+            break;
+        case TileState::Ruby:
+            ruby_tiles.set(tile.index());
+            add_reach(Player::Ruby, tile.index());
+            break;
+        case TileState::Pearl:
+            pearl_tiles.set(tile.index());
+            add_reach(Player::Pearl, tile.index());
+            break;
         }
     }
 }
 
+void Board::add_reach(Player player, int index)
+{
+    auto &planes = reach_counts[player == Player::Ruby ? 0 : 1];
+
+    // ripple-carry increment of every count under the mask
+    auto carry = layout->ring1(index) | layout->ring2(index);
+    for (auto &plane : planes)
+    {
+        const auto next = plane & carry;
+        plane ^= carry;
+        carry = next;
+
+        if (carry.none())
+            break;
+    }
+}
+
+void Board::remove_reach(Player player, int index)
+{
+    auto &planes = reach_counts[player == Player::Ruby ? 0 : 1];
+
+    auto borrow = layout->ring1(index) | layout->ring2(index);
+    for (auto &plane : planes)
+    {
+        const auto next = ~plane & borrow;
+        plane ^= borrow;
+        borrow = next;
+
+        if (borrow.none())
+            break;
+    }
+}
+
+void Board::set_tile(int index, TileState state)
+{
+    const auto bit = Bitboard::bit(index);
+    const auto clear = ~bit;
+
+    ruby_tiles &= clear;
+    pearl_tiles &= clear;
+    empty_tiles &= clear;
+
+    switch (state)
+    {
+    case TileState::Empty:
+        empty_tiles |= bit;
+        break;
+    case TileState::Ruby:
+        ruby_tiles |= bit;
+        break;
+    case TileState::Pearl:
+        pearl_tiles |= bit;
+        break;
+    default:
+        break;
+    }
+
+    const auto previous = map[index];
+    if (previous == TileState::Ruby)
+        remove_reach(Player::Ruby, index);
+    else if (previous == TileState::Pearl)
+        remove_reach(Player::Pearl, index);
+
+    if (state == TileState::Ruby)
+        add_reach(Player::Ruby, index);
+    else if (state == TileState::Pearl)
+        add_reach(Player::Pearl, index);
+
+    tiles_hash ^= ZOBRIST_KEYS.tiles[index][static_cast<int>(previous)] ^ ZOBRIST_KEYS.tiles[index][static_cast<int>(state)];
+    map[index] = state;
+}
+
+Bitboard const &Board::tiles_of(TileState state) const
+{
+    switch (state)
+    {
+    case TileState::Empty:
+        return empty_tiles;
+    case TileState::Ruby:
+        return ruby_tiles;
+    case TileState::Pearl:
+        return pearl_tiles;
+    default:
+        return void_tiles;
+    }
+}
+
 void Board::reset(HexMap<TileState> &&new_map)
 {
     map = std::move(new_map);
     current_player = Player::Ruby;
     highlights.clear();
     selected_tile = {-1, -1};
+    sync_bitboards();
     update_score();
 }
 
-constexpr std::array<std::tuple<int, int, int>, 6> direction_vectors = {
-    // {q, r, s}
-    // first layer
-    std::tuple{0, -1, 1},
-    {1, -1, 0},
-    {1, 0, -1},
-    {0, 1, -1},
-    {-1, 1, 0},
-    {-1, 0, 1},
-};
-
-constexpr std::array<std::tuple<int, int, int>, 18> direction_vectors_two_layer = {
-    // {q, r, s}
-    // first layer
-    std::tuple{0, -1, 1},
-    {1, -1, 0},
-    {1, 0, -1},
-    {0, 1, -1},
-    {-1, 1, 0},
-    {-1, 0, 1},
-
-    // second layer
-    {0, -2, 2},
-    {1, -2, 1},
-    {2, -2, 0},
-    {2, -1, -1},
-    {2, 0, -2},
-    {1, 1, -2},
-    {0, 2, -2},
-    {-1, 2, -1},
-    {-2, 2, 0},
-    {-2, 1, 1},
-    {-2, 0, 2},
-    {-1, -1, 2},
-};
-
 std::vector<std::pair<int, int>> Board::get_possible_moves(int x, int y) const
 {
-    const auto players_tile_type = current_player == Player::Ruby ? TileState::Ruby : TileState::Pearl;
-    const auto starting_tile = map.at(x, y);
+    MoveList<MAX_MOVES_PER_TILE> moves;
+    generate_moves(map.at(x, y).index(), moves);
+
+    std::vector<std::pair<int, int>> result;
+    result.reserve(moves.size());
+
+    for (const auto &move : moves)
+    {
+        result.push_back({move.to % map.get_width(), move.to / map.get_width()});
+    }
 
-    if (starting_tile == map.cend() || *starting_tile != players_tile_type)
+    return result;
+}
+
+void Board::generate_moves(int from, MoveList<MAX_MOVES_PER_TILE> &moves) const
+{
+    moves.clear();
+
+    if (!tiles_of(current_player).test(from))
+    {
+        return;
+    }
+
+    auto targets = (layout->ring1(from) | layout->ring2(from)) & empty_tiles;
+    while (targets.any())
     {
-        return {};
+        moves.push_back({static_cast<uint8_t>(from), static_cast<uint8_t>(targets.pop_lowest())});
     }
+}
+
+void Board::generate_moves(MoveList<MAX_MOVES> &moves) const
+{
+    moves.clear();
 
-    std::vector<std::pair<int, int>> moves;
+    const auto &own = tiles_of(current_player);
 
-    for (const auto [dq, dr, ds] : direction_vectors_two_layer)
+    // every clone into the same tile leads to the same position, so only one of them is generated
+    auto clone_targets = layout->ring1(own) & empty_tiles;
+    while (clone_targets.any())
     {
-        auto tile_off = starting_tile.relative_cube(dq, dr, ds);
-        if (tile_off == map.cend())
-            continue;
+        const auto to = clone_targets.pop_lowest();
+        const auto from = (layout->ring1(to) & own).lowest();
+        moves.push_back({static_cast<uint8_t>(from), static_cast<uint8_t>(to)});
+    }
 
-        // printf("tile_off: %d %d %d -> %d, %d\n", dq, dr, ds, tile_off.face_x(), tile_off.face_y());
+    auto sources = own;
+    while (sources.any())
+    {
+        const auto from = sources.pop_lowest();
 
-        if (*tile_off == TileState::Empty)
+        auto targets = layout->ring2(from) & empty_tiles;
+        while (targets.any())
         {
-            moves.push_back({tile_off.face_x(), tile_off.face_y()});
+            moves.push_back({static_cast<uint8_t>(from), static_cast<uint8_t>(targets.pop_lowest())});
         }
     }
-
-    return moves;
 }
 
 void Board::highlight_moves(int x, int y)
@@ -116,85 +232,135 @@ void Board::clear_highlights()
     highlights.clear();
 }
 
-bool Board::try_move(int x, int y)
+UndoRecord Board::apply_move(int from, int to)
 {
-    auto starting_tile = map.at(selected_tile.first, selected_tile.second);
-
     const auto players_tile_type = current_player == Player::Ruby ? TileState::Ruby : TileState::Pearl;
     const auto opponent_tile_type = current_player == Player::Ruby ? TileState::Pearl : TileState::Ruby;
+    auto &players_score = current_player == Player::Ruby ? ruby_score : pearl_score;
+    auto &opponent_score = current_player == Player::Ruby ? pearl_score : ruby_score;
+
+    UndoRecord record{
+        .from = static_cast<uint8_t>(from),
+        .to = static_cast<uint8_t>(to),
+        .captured = 0,
+    };
 
-    if (starting_tile == map.end())
+    // if we hop to neighboring cell, the gem gets cloned.
+    if (layout->ring1(from).test(to))
     {
-        return false;
+        set_tile(to, players_tile_type);
+        players_score++;
+        empty_count--;
     }
-
-    if (*starting_tile != players_tile_type)
+    // otherwise we move the gem from one cell to another
+    else
     {
-        return false;
+        set_tile(from, TileState::Empty);
+        set_tile(to, players_tile_type);
     }
 
-    auto target_tile = map.at(x, y);
-    if (*target_tile != TileState::Empty)
+    // change all opponent's gems around our target to our gems
+    const auto neighbours = map.ring1_indices(to);
+    for (size_t i = 0; i < neighbours.size(); i++)
     {
-        return false;
+        if (map[neighbours[i]] == opponent_tile_type)
+        {
+            set_tile(neighbours[i], players_tile_type);
+            record.captured |= 1 << i;
+        }
     }
 
-    const auto distance = starting_tile.distance_cube(target_tile);
+    const auto captured_count = std::popcount(record.captured);
+    players_score += captured_count;
+    opponent_score -= captured_count;
 
-    // if we hop to neighboring cell, the gem gets cloned.
-    if (distance == 1)
-    {
-        *target_tile = players_tile_type;
-    }
-    // otherwise we move the gem from one cell to another
-    else if (distance == 2)
+    return record;
+}
+
+bool Board::try_move(int x, int y)
+{
+    const auto [from_x, from_y] = selected_tile;
+    if (from_x < 0 || from_y < 0 || from_x >= map.get_width() || from_y >= map.get_height())
     {
-        *starting_tile = TileState::Empty;
-        *target_tile = players_tile_type;
+        return false;
     }
-    else
+
+    const auto from = map.at(from_x, from_y).index();
+    const auto to = map.at(x, y).index();
+
+    if (!tiles_of(current_player).test(from) || !empty_tiles.test(to))
     {
         return false;
     }
 
-    for (const auto [dq, dr, ds] : direction_vectors)
+    if (!(layout->ring1(from) | layout->ring2(from)).test(to))
     {
-        // change all opponent's gems around our target to our gems
-        auto iter = target_tile.relative_cube(dq, dr, ds);
-        if (iter == map.end())
-            continue;
-
-        if (*iter == opponent_tile_type)
-        {
-            *iter = players_tile_type;
-        }
+        return false;
     }
 
-    update_score();
+    apply_move(from, to);
     selected_tile = {-1, -1};
 
     return true;
 }
 
-bool Board::can_move() const
+UndoRecord Board::make_move(int from, int to)
 {
-    for (auto tile = map.cbegin(); tile != map.cend(); tile++)
+    const auto record = apply_move(from, to);
+    current_player = current_player == Player::Ruby ? Player::Pearl : Player::Ruby;
+    return record;
+}
+
+UndoRecord Board::make_move(MoveInfo const &move)
+{
+    const auto width = map.get_width();
+    return make_move(move.from.second * width + move.from.first, move.to.second * width + move.to.first);
+}
+
+void Board::unmake_move(UndoRecord const &record)
+{
+    // the destination tile always belongs to the player who made the move
+    const auto players_tile_type = map[record.to];
+    const auto opponent_tile_type = players_tile_type == TileState::Ruby ? TileState::Pearl : TileState::Ruby;
+    current_player = players_tile_type == TileState::Ruby ? Player::Ruby : Player::Pearl;
+
+    auto &players_score = current_player == Player::Ruby ? ruby_score : pearl_score;
+    auto &opponent_score = current_player == Player::Ruby ? pearl_score : ruby_score;
+
+    const auto neighbours = map.ring1_indices(record.to);
+    for (size_t i = 0; i < neighbours.size(); i++)
+    {
+        if (record.captured & (1 << i))
+        {
+            set_tile(neighbours[i], opponent_tile_type);
+        }
+    }
+
+    const auto captured_count = std::popcount(record.captured);
+    players_score -= captured_count;
+    opponent_score += captured_count;
+
+    set_tile(record.to, TileState::Empty);
+
+    if (layout->ring1(record.from).test(record.to))
     {
-        if (!get_possible_moves(tile.face_x(), tile.face_y()).empty())
-            return true;
+        players_score--;
+        empty_count++;
     }
+    else
+    {
+        set_tile(record.from, players_tile_type);
+    }
+}
 
-    return false;
+bool Board::can_move() const
+{
+    return any_move();
 }
 
 bool Board::game_ended() const
 {
-    return std::ranges::none_of(map, [](auto const &tile)
-                                { return tile == TileState::Ruby; }) ||
-           std::ranges::none_of(map, [](auto const &tile)
-                                { return tile == TileState::Pearl; }) ||
-           std::ranges::none_of(map, [](auto const &tile)
-                                { return tile == TileState::Empty; });
+    return ruby_score == 0 || pearl_score == 0 || empty_count == 0;
 }
 
 void Board::next_player()
@@ -202,97 +368,42 @@ void Board::next_player()
     if (game_ended())
         return;
 
-    for (;;)
-    {
-        if (current_player == Player::Pearl)
-            current_player = Player::Ruby;
-        else if (current_player == Player::Ruby)
-            current_player = Player::Pearl;
-
-        if (can_move() || game_ended())
-            break;
-    }
+    const auto opponent = other_player(current_player);
+    if (any_move(opponent) || !any_move(current_player))
+        current_player = opponent;
 }
 
-MoveInfo Board::ai_play()
+MoveInfo Board::move_info(Move const &move) const
 {
-    // this could be expanded to chose "least risky" outcome but imo it's good enough for this project
+    const auto width = map.get_width();
 
-    // find move that will take over the most gems
-    const auto players_tile_type = current_player == Player::Ruby ? TileState::Ruby : TileState::Pearl;
-    const auto opponent_tile_type = current_player == Player::Ruby ? TileState::Pearl : TileState::Ruby;
+    return MoveInfo{
+        .from = {move.from % width, move.from / width},
+        .to = {move.to % width, move.to / width},
+    };
+}
 
-    std::pair<int, int> best_from{-1, -1};
-    std::pair<int, int> best_to{-1, -1};
-    int best_move_score = 0;
+MoveInfo Board::ai_play()
+{
+    // the book is mapped once, later calls only look positions up
+    static const auto book = OpeningBook::open_default();
+    thread_local std::mt19937_64 gen{std::random_device{}()};
 
-    for (auto tile = map.cbegin(); tile != map.cend(); tile++)
+    if (book)
     {
-        if (*tile != players_tile_type)
-            continue;
-
-        auto moves = get_possible_moves(tile.face_x(), tile.face_y());
-
-        for (const auto [dx, dy] : moves)
+        if (const auto move = book->choose(*this, gen))
         {
-            auto target_tile = map.at(dx, dy);
-
-            int move_score = 0;
-
-            for (const auto [dq, dr, ds] : direction_vectors)
-            {
-                auto iter = target_tile.relative_cube(dq, dr, ds);
-                if (iter == map.end())
-                    continue;
-
-                if (*iter == opponent_tile_type)
-                {
-                    move_score++;
-                }
-            }
-
-            if (move_score > best_move_score)
-            {
-                best_move_score = move_score;
-                best_from = {tile.face_x(), tile.face_y()};
-                best_to = {dx, dy};
-            }
+            return move_info(*move);
         }
     }
 
-    // pick a random move if we can't find a good one
-    if (best_move_score == 0)
-    {
-        // >_< laziness moment
-        std::vector<std::pair<std::pair<int, int>, std::vector<std::pair<int, int>>>> possible_moves;
-
-        for (auto tile = map.cbegin(); tile != map.cend(); tile++)
-        {
-            if (*tile != players_tile_type)
-                continue;
-            auto moves = get_possible_moves(tile.face_x(), tile.face_y());
-
-            if (!moves.empty())
-            {
-                possible_moves.push_back({{tile.face_x(), tile.face_y()}, std::move(moves)});
-            }
-        }
-
-        if (possible_moves.empty())
-        {
-            throw std::runtime_error("there's no possible moves!");
-        }
-
-        auto &[pos_from, move_list] = random_choice(possible_moves);
-        auto pos_to = random_choice(move_list);
-        best_from = pos_from;
-        best_to = pos_to;
-    }
+    // keep the table between moves, positions searched for the previous move often come up again
+    thread_local auto table = std::make_shared<TranspositionTable>();
 
-    return MoveInfo{
-        .from = best_from,
-        .to = best_to,
-    };
+    Search search;
+    search.set_transposition_table(table);
+    search.set_threads(std::thread::hardware_concurrency());
+    return move_info(search.run(*this, AI_SEARCH_LIMITS).best_move);
 }
 
 constexpr static uint32_t MAGIC_NUMBER = 0x26306B0A;
@@ -354,13 +465,26 @@ void Board::deserialize(std::vector<uint8_t> const &data)
     {
         for (auto x = 0; x < width; x++)
         {
-            tiles[y * width + x] = static_cast<TileState>(reader.read_uint8());
+            const auto tile = reader.read_uint8();
+            if (tile > static_cast<uint8_t>(TileState::Pearl))
+            {
+                throw std::runtime_error("invalid tile state");
+            }
+
+            tiles[y * width + x] = static_cast<TileState>(tile);
         }
     }
 
     map = std::move(HexMap<TileState>(width, height, std::move(tiles)));
+    sync_bitboards();
 
-    current_player = static_cast<Player>(reader.read_uint8());
+    const auto player = reader.read_uint8();
+    if (player > static_cast<uint8_t>(Player::Pearl))
+    {
+        throw std::runtime_error("invalid player");
+    }
+
+    current_player = static_cast<Player>(player);
     auto highlights_size = reader.read_uint32();
     highlights.clear();
 
@@ -372,4 +496,7 @@ void Board::deserialize(std::vector<uint8_t> const &data)
     selected_tile = {reader.read_int32(), reader.read_int32()};
     ruby_score = reader.read_uint32();
     pearl_score = reader.read_uint32();
+
+    // the counters are derived from the tiles, don't trust the stored values
+    update_score();
 }
@@ -1,7 +1,13 @@
 #pragma once
 
 #include "hexmap.h"
+#include "bitboard.h"
+#include "move_list.h"
+#include "zobrist.h"
 
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -24,6 +30,15 @@ namespace hexx::common
         Pearl
     };
 
+    template <>
+    struct HexTileTraits<TileState>
+    {
+        static constexpr bool is_void(TileState const &tile)
+        {
+            return tile == TileState::Void;
+        }
+    };
+
     /**
      * @brief This enumeration is used to represent the two players in the game.
      */
@@ -33,6 +48,14 @@ namespace hexx::common
         Pearl,
     };
 
+    /**
+     * @return Player the opponent of the specified player.
+     */
+    constexpr Player other_player(Player player)
+    {
+        return player == Player::Ruby ? Player::Pearl : Player::Ruby;
+    }
+
     /**
      * @brief Struct for storing information about a move made by a player.
      * This struct contains information about a move made by a player, including the start and end positions.
@@ -43,13 +66,76 @@ namespace hexx::common
         std::pair<int, int> to;
     };
 
+    /**
+     * @brief Compact record of a move applied with Board::make_move, used to take the move back.
+     */
+    struct UndoRecord
+    {
+        /**
+         * @brief Flat index of the tile the gem moved from.
+         */
+        uint8_t from;
+
+        /**
+         * @brief Flat index of the tile the gem moved to.
+         */
+        uint8_t to;
+
+        /**
+         * @brief Bit i is set if the i-th tile of HexMap::ring1_indices(to) was captured.
+         */
+        uint8_t captured;
+    };
+
     /**
      * @brief Represents the state of the game board.
      */
     class Board
     {
+        std::shared_ptr<const BoardLayout> layout{};
+        Bitboard ruby_tiles{};
+        Bitboard pearl_tiles{};
+        Bitboard empty_tiles{};
+        Bitboard void_tiles{};
+        int empty_count{0};
+        uint64_t tiles_hash{0};
+
+        /**
+         * @brief For each player, how many of its gems are within two tiles of every tile, as bit planes:
+         * plane i holds bit i of every count. At most 18 tiles are that close, so five planes are enough.
+         */
+        std::array<std::array<Bitboard, 5>, 2> reach_counts{};
+
+        /**
+         * @brief Adds a gem of the player at the tile to the counts of the tiles around it.
+         */
+        void add_reach(Player player, int index);
+
+        /**
+         * @brief Removes a gem of the player at the tile from the counts of the tiles around it.
+         */
+        void remove_reach(Player player, int index);
+
+        /**
+         * @brief Recounts the scores and empty tiles from scratch.
+         */
         void update_score();
 
+        /**
+         * @brief Applies a legal move for the current player, without changing the turn.
+         */
+        UndoRecord apply_move(int from, int to);
+
+        /**
+         * @brief Rebuilds the layout, tile bitboards and hash from the map.
+         */
+        void sync_bitboards();
+
+        /**
+         * @brief Writes a tile to both the map and the bitboards.
+         */
+        void set_tile(int index, TileState state);
+
     public:
         HexMap<TileState> map{};
         Player current_player = Player::Ruby;
@@ -66,6 +152,46 @@ namespace hexx::common
          */
         void reset(HexMap<TileState> &&new_map);
 
+        /**
+         * @return BoardLayout const& precomputed geometry of the current map.
+         */
+        BoardLayout const &get_layout() const
+        {
+            return *layout;
+        }
+
+        /**
+         * @return int number of empty tiles left on the board.
+         */
+        int get_empty_count() const
+        {
+            return empty_count;
+        }
+
+        /**
+         * @brief Returns the Zobrist hash of the position: every tile and the player to move.
+         * Maintained incrementally, so this is O(1).
+         *
+         * @return uint64_t hash of the position
+         */
+        uint64_t hash() const
+        {
+            return current_player == Player::Pearl ? tiles_hash ^ ZOBRIST_KEYS.side : tiles_hash;
+        }
+
+        /**
+         * @return Bitboard tiles of the specified state.
+         */
+        Bitboard const &tiles_of(TileState state) const;
+
+        /**
+         * @return Bitboard tiles occupied by the specified player.
+         */
+        Bitboard const &tiles_of(Player player) const
+        {
+            return player == Player::Ruby ? ruby_tiles : pearl_tiles;
+        }
+
         /**
          * @brief Returns a vector containing possible moves starting from tile at specified coordinates.
          *
@@ -75,6 +201,66 @@ namespace hexx::common
          */
         std::vector<std::pair<int, int>> get_possible_moves(int x, int y) const;
 
+        /**
+         * @brief Fills the list with moves of the current player starting from the specified tile.
+         *
+         * @param from flat index of the tile
+         * @param moves list to fill, cleared first
+         */
+        void generate_moves(int from, MoveList<MAX_MOVES_PER_TILE> &moves) const;
+
+        /**
+         * @brief Fills the list with all moves of the current player. Clones into the same tile lead to
+         * the same position, so only one clone per destination is generated, followed by all jumps.
+         *
+         * @param moves list to fill, cleared first
+         */
+        void generate_moves(MoveList<MAX_MOVES> &moves) const;
+
+        /**
+         * @brief Returns the tiles within two tiles of the player's gems, maintained incrementally as gems
+         * are placed and taken, so this is O(1). The empty ones are the player's move destinations.
+         */
+        Bitboard reach_of(Player player) const
+        {
+            const auto &planes = reach_counts[player == Player::Ruby ? 0 : 1];
+            return planes[0] | planes[1] | planes[2] | planes[3] | planes[4];
+        }
+
+        /**
+         * @brief Checks if the player has any move, without generating them. O(1).
+         */
+        bool any_move(Player player) const
+        {
+            return (reach_of(player) & empty_tiles).any();
+        }
+
+        /**
+         * @brief Checks if the current player has any move, without generating them. O(1).
+         *
+         * @return true if at least one move exists
+         */
+        bool any_move() const
+        {
+            return any_move(current_player);
+        }
+
+        /**
+         * @brief Checks if neither player has a move, which ends the game even with empty tiles left. O(1).
+         */
+        bool no_moves_left() const
+        {
+            return !any_move(Player::Ruby) && !any_move(Player::Pearl);
+        }
+
+        /**
+         * @return int number of distinct tiles the current player can move into.
+         */
+        int destination_count() const
+        {
+            return (reach_of(current_player) & empty_tiles).count();
+        }
+
         /**
          * @brief Highlight tiles the player can move to starting from the specified tile.
          */
@@ -92,6 +278,38 @@ namespace hexx::common
          */
         bool try_move(int x, int y);
 
+        /**
+         * @brief Applies a move for the current player and passes the turn to the opponent, without checking
+         * if the opponent can move. Unlike try_move, the move is not validated and selected_tile is ignored.
+         * Intended for search, where moves come from the move generator.
+         *
+         * @param from flat index of the tile to move from
+         * @param to flat index of the tile to move to
+         * @return UndoRecord record to pass to unmake_move
+         */
+        UndoRecord make_move(int from, int to);
+
+        /**
+         * @brief Applies a move for the current player and passes the turn to the opponent.
+         *
+         * @param move a legal move for the current player
+         * @return UndoRecord record to pass to unmake_move
+         */
+        UndoRecord make_move(MoveInfo const &move);
+
+        /**
+         * @brief Takes back a move applied with make_move and gives the turn back to the player who made it.
+         * Moves must be taken back in reverse order.
+         *
+         * @param record record returned by make_move
+         */
+        void unmake_move(UndoRecord const &record);
+
+        /**
+         * @brief Converts a move given in flat tile indices to tile coordinates.
+         */
+        MoveInfo move_info(Move const &move) const;
+
         /**
          * @brief Checks if the current player can move.
          *
@@ -107,15 +325,14 @@ namespace hexx::common
         bool game_ended() const;
 
         /**
-         * @brief Gives the turn to next player who can make a move.
-         *
+         * @brief Gives the turn to the next player who can make a move. If the opponent can't, the current
+         * player keeps the turn; if neither can, the turn passes anyway.
          */
         void next_player();
 
         /**
          * @brief This function is used to compute the next move for the AI player.
-         * The AI player will try to find a move that will take over the most gems.
-         * If no such move can be found, it will pick a random move.
+         * Runs a time-limited Search with the default evaluation.
          *
          * @return MoveInfo  a struct containing the start and end positions of the move determined by the AI.
          */
@@ -0,0 +1,376 @@
+#include "board_batch.h"
+
+#include <array>
+#include <stdexcept>
+
+using namespace hexx::common;
+
+/**
+ * @brief Adds the tiles of every game's bitboard, moved by a shift, to the games' bitboards in to.
+ * The branches only depend on the shift, so every loop runs over plain word arrays.
+ */
+static void shift_into(size_t count, uint64_t const *from_lo, uint64_t const *from_hi, BoardLayout::Shift const &shift,
+                       uint64_t *to_lo, uint64_t *to_hi)
+{
+    const auto sources_lo = shift.sources.low_word();
+    const auto sources_hi = shift.sources.high_word();
+    const auto delta = shift.delta;
+
+    if (delta >= 64)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            to_hi[i] |= (from_lo[i] & sources_lo) << (delta - 64);
+        }
+    }
+    else if (delta > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto lo = from_lo[i] & sources_lo;
+            const auto hi = from_hi[i] & sources_hi;
+            to_lo[i] |= lo << delta;
+            to_hi[i] |= (hi << delta) | (lo >> (64 - delta));
+        }
+    }
+    else if (delta > -64)
+    {
+        const auto right = -delta;
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto lo = from_lo[i] & sources_lo;
+            const auto hi = from_hi[i] & sources_hi;
+            to_lo[i] |= (lo >> right) | (hi << (64 - right));
+            to_hi[i] |= hi >> right;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            to_lo[i] |= (from_hi[i] & sources_hi) >> (-delta - 64);
+        }
+    }
+}
+
+/**
+ * @brief Bit planes of the gem gain of moving into every tile of a word: opponent gems around the tile,
+ * summed by a bit-sliced adder over the six directional steps, plus one for a clone.
+ */
+static void gain_bits(std::array<uint64_t, 6> const &step, uint64_t clones, uint64_t (&gain)[3])
+{
+    const auto [a, b, c, d, e, f] = step;
+
+    const auto sum_abc = a ^ b ^ c;
+    const auto carry_abc = (a & b) | (c & (a ^ b));
+    const auto sum_def = d ^ e ^ f;
+    const auto carry_def = (d & e) | (f & (d ^ e));
+    const auto carry_ones = sum_abc & sum_def;
+
+    const auto count0 = sum_abc ^ sum_def;
+    const auto count1 = carry_abc ^ carry_def ^ carry_ones;
+    const auto count2 = (carry_abc & carry_def) | (carry_ones & (carry_abc ^ carry_def));
+
+    // at most 6 captures, so adding the clone never carries out of the third plane
+    const auto carry0 = count0 & clones;
+    gain[0] = count0 ^ clones;
+    gain[1] = count1 ^ carry0;
+    gain[2] = count2 ^ (count1 & carry0);
+}
+
+/**
+ * @return int index of a random tile of a non-empty bitboard.
+ */
+static int random_tile(Bitboard bits, std::mt19937_64 &gen)
+{
+    for (auto skip = gen() % bits.count(); skip > 0; skip--)
+    {
+        bits.pop_lowest();
+    }
+
+    return bits.lowest();
+}
+
+BoardBatch::BoardBatch(Board const &start, size_t count)
+    : layout(std::make_shared<const BoardLayout>(start.get_layout().get_width(), start.get_layout().get_height())),
+      count(count)
+{
+    for (auto plane : {&ruby, &pearl, &empty, &own, &opponent, &clone_targets, &jump_targets, &best_targets})
+    {
+        plane->resize(count);
+    }
+
+    for (auto &plane : steps)
+    {
+        plane.resize(count);
+    }
+
+    player.resize(count);
+    finished.resize(count);
+    chosen.resize(count, NO_MOVE);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        set(i, start);
+    }
+}
+
+void BoardBatch::set(size_t index, Board const &board)
+{
+    if (board.get_layout().get_width() != layout->get_width() || board.get_layout().get_height() != layout->get_height())
+    {
+        throw std::invalid_argument("board size differs from the batch");
+    }
+
+    ruby.set(index, board.tiles_of(TileState::Ruby));
+    pearl.set(index, board.tiles_of(TileState::Pearl));
+    empty.set(index, board.tiles_of(TileState::Empty));
+    player[index] = board.current_player;
+    finished[index] = 0;
+    chosen[index] = NO_MOVE;
+}
+
+Board BoardBatch::board(size_t index) const
+{
+    const auto tile_count = layout->get_width() * layout->get_height();
+    const auto ruby_tiles = ruby.get(index);
+    const auto pearl_tiles = pearl.get(index);
+    const auto empty_tiles = empty.get(index);
+
+    std::vector<TileState> tiles(tile_count, TileState::Void);
+    for (int i = 0; i < tile_count; i++)
+    {
+        if (ruby_tiles.test(i))
+            tiles[i] = TileState::Ruby;
+        else if (pearl_tiles.test(i))
+            tiles[i] = TileState::Pearl;
+        else if (empty_tiles.test(i))
+            tiles[i] = TileState::Empty;
+    }
+
+    Board result;
+    result.reset(HexMap<TileState>(layout->get_width(), layout->get_height(), std::move(tiles)));
+    result.current_player = player[index];
+
+    return result;
+}
+
+void BoardBatch::set_targets(size_t index)
+{
+    const auto own_tiles = own.get(index);
+    const auto empty_tiles = empty.get(index);
+    const auto clones = layout->ring1(own_tiles) & empty_tiles;
+
+    clone_targets.set(index, clones);
+    jump_targets.set(index, layout->ring2(own_tiles) & empty_tiles & ~clones);
+}
+
+void BoardBatch::generate()
+{
+    // pick the planes of the player to move with a mask rather than a branch
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint64_t pearl_moves = player[i] == Player::Pearl ? ~0ULL : 0;
+        own.lo[i] = (ruby.lo[i] & ~pearl_moves) | (pearl.lo[i] & pearl_moves);
+        own.hi[i] = (ruby.hi[i] & ~pearl_moves) | (pearl.hi[i] & pearl_moves);
+        opponent.lo[i] = (pearl.lo[i] & ~pearl_moves) | (ruby.lo[i] & pearl_moves);
+        opponent.hi[i] = (pearl.hi[i] & ~pearl_moves) | (ruby.hi[i] & pearl_moves);
+    }
+
+    clone_targets.resize(count);
+    jump_targets.resize(count);
+
+    for (const auto &by_parity : layout->get_ring1_shifts())
+    {
+        for (const auto &shift : by_parity)
+        {
+            shift_into(count, own.lo.data(), own.hi.data(), shift, clone_targets.lo.data(), clone_targets.hi.data());
+        }
+    }
+
+    for (const auto &by_parity : layout->get_ring2_shifts())
+    {
+        for (const auto &shift : by_parity)
+        {
+            shift_into(count, own.lo.data(), own.hi.data(), shift, jump_targets.lo.data(), jump_targets.hi.data());
+        }
+    }
+
+    // destinations are empty, and a tile that can be cloned into is never jumped into
+    for (size_t i = 0; i < count; i++)
+    {
+        clone_targets.lo[i] &= empty.lo[i];
+        clone_targets.hi[i] &= empty.hi[i];
+        jump_targets.lo[i] &= empty.lo[i] & ~clone_targets.lo[i];
+        jump_targets.hi[i] &= empty.hi[i] & ~clone_targets.hi[i];
+    }
+
+    running_count = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (finished[i])
+            continue;
+
+        if (ruby.get(i).none() || pearl.get(i).none() || empty.get(i).none())
+        {
+            finished[i] = 1;
+            continue;
+        }
+
+        if ((clone_targets.get(i) | jump_targets.get(i)).none())
+        {
+            const auto opponent_tiles = opponent.get(i);
+            if (((layout->ring1(opponent_tiles) | layout->ring2(opponent_tiles)) & empty.get(i)).none())
+            {
+                finished[i] = 1;
+                continue;
+            }
+
+            // the player passes
+            player[i] = other_player(player[i]);
+            opponent.set(i, own.get(i));
+            own.set(i, opponent_tiles);
+            set_targets(i);
+        }
+
+        running_count++;
+    }
+}
+
+void BoardBatch::select_random(std::mt19937_64 &gen)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (finished[i])
+        {
+            chosen[i] = NO_MOVE;
+            continue;
+        }
+
+        const auto clones = clone_targets.get(i);
+        const auto to = random_tile(clones | jump_targets.get(i), gen);
+        const auto from = clones.test(to) ? (layout->ring1(to) & own.get(i)).lowest()
+                                          : random_tile(layout->ring2(to) & own.get(i), gen);
+
+        chosen[i] = {static_cast<uint8_t>(from), static_cast<uint8_t>(to)};
+    }
+}
+
+void BoardBatch::select_greedy(std::mt19937_64 &gen)
+{
+    // opponent gems next to every tile, one plane per direction
+    const auto &shifts = layout->get_ring1_shifts();
+    for (size_t d = 0; d < shifts.size(); d++)
+    {
+        steps[d].resize(count);
+
+        for (const auto &shift : shifts[d])
+        {
+            shift_into(count, opponent.lo.data(), opponent.hi.data(), shift, steps[d].lo.data(), steps[d].hi.data());
+        }
+    }
+
+    // a gain is at most 7, so the destinations with the highest top bit of it, then of the next bit and so on,
+    // are the best ones; a bit that no destination of a game has leaves the game's destinations as they are
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t gain_lo[3];
+        uint64_t gain_hi[3];
+        gain_bits({steps[0].lo[i], steps[1].lo[i], steps[2].lo[i], steps[3].lo[i], steps[4].lo[i], steps[5].lo[i]},
+                  clone_targets.lo[i], gain_lo);
+        gain_bits({steps[0].hi[i], steps[1].hi[i], steps[2].hi[i], steps[3].hi[i], steps[4].hi[i], steps[5].hi[i]},
+                  clone_targets.hi[i], gain_hi);
+
+        auto lo = clone_targets.lo[i] | jump_targets.lo[i];
+        auto hi = clone_targets.hi[i] | jump_targets.hi[i];
+
+        for (int bit = 2; bit >= 0; bit--)
+        {
+            const auto kept_lo = lo & gain_lo[bit];
+            const auto kept_hi = hi & gain_hi[bit];
+            const uint64_t keep = (kept_lo | kept_hi) != 0 ? ~0ULL : 0;
+
+            lo = (kept_lo & keep) | (lo & ~keep);
+            hi = (kept_hi & keep) | (hi & ~keep);
+        }
+
+        best_targets.lo[i] = lo;
+        best_targets.hi[i] = hi;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (finished[i])
+        {
+            chosen[i] = NO_MOVE;
+            continue;
+        }
+
+        const auto to = random_tile(best_targets.get(i), gen);
+        const auto from = clone_targets.get(i).test(to) ? (layout->ring1(to) & own.get(i)).lowest()
+                                                        : random_tile(layout->ring2(to) & own.get(i), gen);
+
+        chosen[i] = {static_cast<uint8_t>(from), static_cast<uint8_t>(to)};
+    }
+}
+
+void BoardBatch::apply()
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto move = chosen[i];
+        if (finished[i] || move == NO_MOVE)
+            continue;
+
+        auto own_tiles = own.get(i);
+        auto opponent_tiles = opponent.get(i);
+        auto empty_tiles = empty.get(i);
+
+        const auto captured = layout->ring1(move.to) & opponent_tiles;
+        own_tiles |= Bitboard::bit(move.to) | captured;
+        opponent_tiles &= ~captured;
+        empty_tiles.reset(move.to);
+
+        if (!layout->ring1(move.from).test(move.to))
+        {
+            own_tiles.reset(move.from);
+            empty_tiles.set(move.from);
+        }
+
+        if (player[i] == Player::Ruby)
+        {
+            ruby.set(i, own_tiles);
+            pearl.set(i, opponent_tiles);
+        }
+        else
+        {
+            pearl.set(i, own_tiles);
+            ruby.set(i, opponent_tiles);
+        }
+
+        empty.set(i, empty_tiles);
+        player[i] = other_player(player[i]);
+        chosen[i] = NO_MOVE;
+    }
+}
+
+void BoardBatch::play_out(std::mt19937_64 &gen, bool greedy, int max_plies)
+{
+    for (int ply = 0; ply < max_plies; ply++)
+    {
+        generate();
+
+        if (running_count == 0)
+            return;
+
+        if (greedy)
+            select_greedy(gen);
+        else
+            select_random(gen);
+
+        apply();
+    }
+
+    generate();
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace hexx::common
+{
+    /**
+     * @brief Many independent games on boards of the same size, advanced in lockstep.
+     *
+     * Positions are stored as a structure of arrays: every tile plane is split into an array of low words
+     * (tiles 0-63) and an array of high words (tiles 64-127) indexed by game. A neighbourhood shift is then one
+     * loop over all the games with the same shift count, which compilers turn into vector code. Picking and
+     * applying moves still handle the games one at a time, but only with bitboard operations.
+     *
+     * A step is generate(), then select_random() or select_greedy(), then apply(). generate() also resolves
+     * passes like Board::next_player does and detects finished games, which the other calls skip.
+     */
+    class BoardBatch
+    {
+        /**
+         * @brief A bitboard for every game, split into word arrays.
+         */
+        struct Plane
+        {
+            std::vector<uint64_t> lo;
+            std::vector<uint64_t> hi;
+
+            void resize(size_t count)
+            {
+                lo.assign(count, 0);
+                hi.assign(count, 0);
+            }
+
+            Bitboard get(size_t index) const
+            {
+                return {lo[index], hi[index]};
+            }
+
+            void set(size_t index, Bitboard const &bits)
+            {
+                lo[index] = bits.low_word();
+                hi[index] = bits.high_word();
+            }
+        };
+
+        std::shared_ptr<const BoardLayout> layout;
+        size_t count;
+
+        Plane ruby;
+        Plane pearl;
+        Plane empty;
+
+        /**
+         * @brief Player to move in every game.
+         */
+        std::vector<Player> player;
+
+        std::vector<uint8_t> finished;
+        size_t running_count{0};
+
+        // filled by generate(), for the player to move
+        Plane own;
+        Plane opponent;
+        Plane clone_targets;
+        Plane jump_targets;
+
+        // filled by select_greedy(): opponent gems in every direction and the destinations gaining the most
+        Plane steps[6];
+        Plane best_targets;
+
+        std::vector<Move> chosen;
+
+        /**
+         * @brief Destinations of the player to move in one game, after a pass.
+         */
+        void set_targets(size_t index);
+
+    public:
+        /**
+         * @brief Value of a chosen move in a game that is finished.
+         */
+        static constexpr Move NO_MOVE{0xFF, 0xFF};
+
+        /**
+         * @brief Makes a batch of copies of a position.
+         *
+         * @param start position of every game
+         * @param count number of games
+         */
+        BoardBatch(Board const &start, size_t count);
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        /**
+         * @brief Replaces the position of one game.
+         *
+         * @throws invalid_argument if the board isn't the size of the batch.
+         */
+        void set(size_t index, Board const &board);
+
+        /**
+         * @return Board the position of one game.
+         */
+        Board board(size_t index) const;
+
+        /**
+         * @brief Computes the destinations of the player to move in every game. A player without moves passes,
+         * a game without moves for either player, or without gems of a player or empty tiles, is finished.
+         */
+        void generate();
+
+        /**
+         * @brief Picks a move in every running game, a random destination and a clone into it if there is one.
+         * Needs generate() first.
+         */
+        void select_random(std::mt19937_64 &gen);
+
+        /**
+         * @brief Picks the move gaining the most gems in every running game, captures plus one for a clone,
+         * with ties broken at random. Needs generate() first.
+         */
+        void select_greedy(std::mt19937_64 &gen);
+
+        /**
+         * @brief Plays the selected move in every running game.
+         */
+        void apply();
+
+        /**
+         * @brief Plays every game until it finishes, or until max_plies steps.
+         *
+         * @param gen random number generator
+         * @param greedy use select_greedy() rather than select_random()
+         * @param max_plies most steps to play
+         */
+        void play_out(std::mt19937_64 &gen, bool greedy, int max_plies);
+
+        /**
+         * @return size_t number of games not finished at the last generate().
+         */
+        size_t running() const
+        {
+            return running_count;
+        }
+
+        bool is_finished(size_t index) const
+        {
+            return finished[index] != 0;
+        }
+
+        /**
+         * @return Move the move selected in a game, NO_MOVE if it's finished.
+         */
+        Move selected(size_t index) const
+        {
+            return chosen[index];
+        }
+
+        /**
+         * @return int Ruby's gems minus Pearl's in one game.
+         */
+        int margin(size_t index) const
+        {
+            return ruby.get(index).count() - pearl.get(index).count();
+        }
+    };
+}
@@ -0,0 +1,153 @@
+#include "endgame.h"
+#include "gain_map.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+using namespace hexx::common;
+
+// finished games outrank any gem difference at the horizon, like Search::terminal_score
+constexpr int SCORE_FINAL = 2 * Bitboard::CAPACITY;
+constexpr int SCORE_INFINITE = 2 * SCORE_FINAL;
+
+static int margin_of(Board const &board)
+{
+    const auto margin = board.ruby_score - board.pearl_score;
+    return board.current_player == Player::Ruby ? margin : -margin;
+}
+
+static int final_score(Board const &board)
+{
+    const auto margin = margin_of(board);
+    return margin > 0 ? SCORE_FINAL + margin : margin < 0 ? -SCORE_FINAL + margin : 0;
+}
+
+static void order_by_captures(Board const &board, MoveList<MAX_MOVES> &moves)
+{
+    const auto &layout = board.get_layout();
+
+    GainMap gains;
+    gains.compute(board);
+
+    std::array<int8_t, MAX_MOVES> keys;
+
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        const auto &move = moves[i];
+        keys[i] = gains[move.to] * 2 + (layout.ring1(move.from).test(move.to) ? 1 : 0);
+    }
+
+    for (size_t i = 1; i < moves.size(); i++)
+    {
+        const auto key = keys[i];
+        const auto move = moves[i];
+        auto j = i;
+
+        for (; j > 0 && keys[j - 1] < key; j--)
+        {
+            keys[j] = keys[j - 1];
+            moves[j] = moves[j - 1];
+        }
+
+        keys[j] = key;
+        moves[j] = move;
+    }
+}
+
+int EndgameSolver::solve_node(Board &board, int ply, int alpha, int beta)
+{
+    if ((++nodes & 1023) == 0 && should_stop && should_stop())
+        aborted = true;
+
+    if (aborted)
+        return 0;
+
+    if (board.game_ended())
+        return final_score(board);
+
+    if (ply >= horizon)
+    {
+        cut = true;
+        return margin_of(board);
+    }
+
+    MoveList<MAX_MOVES> moves;
+    board.generate_moves(moves);
+
+    if (moves.empty())
+    {
+        board.current_player = other_player(board.current_player);
+        const auto score = board.any_move() ? -solve_node(board, ply + 1, -beta, -alpha)
+                                            : -final_score(board);
+        board.current_player = other_player(board.current_player);
+
+        return score;
+    }
+
+    order_by_captures(board, moves);
+
+    int best = -SCORE_INFINITE;
+
+    for (const auto &move : moves)
+    {
+        const auto record = board.make_move(move.from, move.to);
+        const auto score = -solve_node(board, ply + 1, -beta, -alpha);
+        board.unmake_move(record);
+
+        if (aborted)
+            return 0;
+
+        if (score <= best)
+            continue;
+
+        best = score;
+
+        if (ply == 0)
+            best_move = move;
+
+        if (score > alpha)
+        {
+            alpha = score;
+
+            if (alpha >= beta)
+                break;
+        }
+    }
+
+    return best;
+}
+
+EndgameResult EndgameSolver::solve(Board const &board, std::function<bool()> should_stop)
+{
+    Board position = board;
+
+    if (position.game_ended())
+    {
+        throw std::runtime_error("the game is over!");
+    }
+
+    if (!position.any_move())
+    {
+        throw std::runtime_error("there's no possible moves!");
+    }
+
+    this->should_stop = std::move(should_stop);
+    horizon = std::max(position.get_empty_count() * HORIZON_PER_EMPTY, 1);
+    nodes = 0;
+    aborted = false;
+    cut = false;
+
+    const auto score = solve_node(position, 0, -SCORE_INFINITE, SCORE_INFINITE);
+    const auto decided = score >= SCORE_FINAL || score <= -SCORE_FINAL;
+
+    return EndgameResult{
+        .best_move = best_move,
+        .margin = score >= SCORE_FINAL ? score - SCORE_FINAL : score <= -SCORE_FINAL ? score + SCORE_FINAL : score,
+        .decided = decided && !aborted,
+        .exact = !aborted && !cut,
+        .aborted = aborted,
+        .depth = horizon,
+        .nodes = nodes,
+    };
+}
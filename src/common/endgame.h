@@ -0,0 +1,90 @@
+#pragma once
+
+#include "board.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace hexx::common
+{
+    /**
+     * @brief Default number of empty tiles at or below which Search hands the position to EndgameSolver.
+     */
+    constexpr int DEFAULT_ENDGAME_EMPTIES = 4;
+
+    /**
+     * @brief Outcome of an endgame solve.
+     */
+    struct EndgameResult
+    {
+        Move best_move{};
+
+        /**
+         * @brief Gem difference for the player to move under best play: the final one if decided is set,
+         * otherwise the one at the ply horizon.
+         */
+        int margin{0};
+
+        /**
+         * @brief True if the game is won or lost by force within the horizon, whatever happens in the lines it cuts.
+         * Draws are never reported as decided.
+         */
+        bool decided{false};
+
+        /**
+         * @brief True if no line was cut by the ply horizon, so margin is the exact game-theoretic result.
+         */
+        bool exact{false};
+
+        /**
+         * @brief True if the solver was told to stop before finishing, best_move and margin are then unreliable.
+         */
+        bool aborted{false};
+
+        /**
+         * @brief Ply horizon of the solve.
+         */
+        int depth{0};
+
+        uint64_t nodes{0};
+    };
+
+    /**
+     * @brief Alpha-beta solver for positions with few empty tiles, scoring the final gem difference.
+     *
+     * Leaner than Search: no transposition table, no evaluator and no principal variation, just captures-first
+     * move ordering and the board's incrementally kept gem counts. Passes follow Board::next_player.
+     *
+     * Clones fill a tile but jumps leave one empty behind, so the game isn't guaranteed to end within
+     * a number of moves given by the empties, a losing side can keep jumping around instead. Lines longer
+     * than the ply horizon are scored by their gem difference, below any finished game, the way Search
+     * scores its leaves.
+     */
+    class EndgameSolver
+    {
+        std::function<bool()> should_stop{};
+        int horizon{0};
+        uint64_t nodes{0};
+        bool aborted{false};
+        bool cut{false};
+        Move best_move{};
+
+        int solve_node(Board &board, int ply, int alpha, int beta);
+
+    public:
+        /**
+         * @brief Plies allowed per empty tile before a line is cut off.
+         */
+        static constexpr int HORIZON_PER_EMPTY = 2;
+
+        /**
+         * @brief Solves the position for the player to move.
+         *
+         * @param board position to solve, left unchanged
+         * @param should_stop called every 1024 nodes, the solve is aborted once it returns true
+         * @return EndgameResult the best move and its final margin
+         * @throws runtime_error if the game is over or the player to move has no moves.
+         */
+        EndgameResult solve(Board const &board, std::function<bool()> should_stop = {});
+    };
+}
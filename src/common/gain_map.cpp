@@ -0,0 +1,149 @@
+#include "gain_map.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HEXX_GAIN_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace hexx::common;
+
+void GainMap::compute(BoardLayout const &layout, Bitboard const &targets)
+{
+    // two full adders over three directions each, then one over the two carries and the carry of the ones
+    Bitboard steps[6];
+    for (int d = 0; d < 6; d++)
+    {
+        steps[d] = layout.step(targets, d);
+    }
+
+    const auto &[a, b, c, d, e, f] = steps;
+
+    const auto sum_abc = a ^ b ^ c;
+    const auto carry_abc = (a & b) | (c & (a ^ b));
+    const auto sum_def = d ^ e ^ f;
+    const auto carry_def = (d & e) | (f & (d ^ e));
+    const auto carry_ones = sum_abc & sum_def;
+
+    count_bits[0] = sum_abc ^ sum_def;
+    count_bits[1] = carry_abc ^ carry_def ^ carry_ones;
+    count_bits[2] = (carry_abc & carry_def) | (carry_ones & (carry_abc ^ carry_def));
+
+    const uint64_t words[3][2] = {
+        {count_bits[0].low_word(), count_bits[0].high_word()},
+        {count_bits[1].low_word(), count_bits[1].high_word()},
+        {count_bits[2].low_word(), count_bits[2].high_word()},
+    };
+
+    // only the board's tiles are unpacked, rounded up to a whole step
+    const auto tile_count = layout.get_width() * layout.get_height();
+
+    // every byte gets eight copies of the plane byte covering it, tests its own bit and keeps the plane's weight
+#if defined(__AVX2__)
+    const auto select = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+    const auto spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                         2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+
+    for (int i = 0; i < tile_count; i += 32)
+    {
+        const auto w = i / 64;
+        const auto shift = i % 64;
+
+        // four bytes of bits broadcast to every lane, then each byte shuffled into its eight lanes
+        const auto plane = [&](int k)
+        {
+            const auto bits = _mm256_set1_epi32(static_cast<int>(words[k][w] >> shift));
+            const auto copies = _mm256_shuffle_epi8(bits, spread);
+            const auto set = _mm256_cmpeq_epi8(_mm256_and_si256(copies, select), select);
+            return _mm256_and_si256(set, _mm256_set1_epi8(static_cast<char>(1 << k)));
+        };
+
+        const auto sum = _mm256_or_si256(_mm256_or_si256(plane(0), plane(1)), plane(2));
+
+        _mm256_store_si256(reinterpret_cast<__m256i *>(gains.data() + i), sum);
+    }
+#elif defined(HEXX_GAIN_MAP_SSE2)
+    const auto select = _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+
+    for (int i = 0; i < tile_count; i += 16)
+    {
+        const auto w = i / 64;
+        const auto shift = i % 64;
+
+        // two bytes of bits widened by unpacking with themselves, each ends up in eight lanes
+        const auto plane = [&](int k)
+        {
+            auto copies = _mm_cvtsi32_si128(static_cast<int>((words[k][w] >> shift) & 0xFFFF));
+            copies = _mm_unpacklo_epi8(copies, copies);
+            copies = _mm_unpacklo_epi16(copies, copies);
+            copies = _mm_unpacklo_epi32(copies, copies);
+
+            const auto set = _mm_cmpeq_epi8(_mm_and_si128(copies, select), select);
+            return _mm_and_si128(set, _mm_set1_epi8(static_cast<char>(1 << k)));
+        };
+
+        const auto sum = _mm_or_si128(_mm_or_si128(plane(0), plane(1)), plane(2));
+
+        _mm_store_si128(reinterpret_cast<__m128i *>(gains.data() + i), sum);
+    }
+#else
+    for (int i = 0; i < tile_count; i += 8)
+    {
+        const auto w = i / 64;
+        const auto b = (i % 64) / 8;
+        uint64_t sum = 0;
+
+        // the same bit test done on a word, bit k of the low seven lands on bit 0 of byte k
+        for (int k = 0; k < 3; k++)
+        {
+            const auto byte = (words[k][w] >> (b * 8)) & 0xFF;
+            const auto spread = (((byte & 0x7F) * 0x0002040810204081ULL) & 0x0101010101010101ULL) | ((byte >> 7) << 56);
+            sum |= spread << k;
+        }
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            std::memcpy(gains.data() + i, &sum, 8);
+        }
+        else
+        {
+            for (int j = 0; j < 8; j++)
+            {
+                gains[i + j] = static_cast<uint8_t>(sum >> (j * 8));
+            }
+        }
+    }
+#endif
+}
+
+Bitboard GainMap::at_least(int count) const
+{
+    if (count <= 0)
+        return ~Bitboard{};
+    if (count > 7)
+        return {};
+
+    // compare the bit-sliced counts from the top bit down
+    const auto threshold = count - 1;
+    Bitboard greater{};
+    Bitboard equal = ~Bitboard{};
+
+    for (int k = 2; k >= 0; k--)
+    {
+        if (threshold & (1 << k))
+        {
+            equal &= count_bits[k];
+        }
+        else
+        {
+            greater |= equal & count_bits[k];
+            equal &= ~count_bits[k];
+        }
+    }
+
+    return greater;
+}
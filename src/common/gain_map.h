@@ -0,0 +1,59 @@
+#pragma once
+
+#include "board.h"
+
+#include <array>
+#include <cstdint>
+
+namespace hexx::common
+{
+    /**
+     * @brief Capture gain of every tile at once: the number of target gems around each tile, which is what
+     * a move into the tile captures when the targets are the opponent's gems.
+     *
+     * The targets are stepped in each of the six directions with bitboard shifts and the six sets are summed
+     * by a bit-sliced adder, which counts for all 128 tiles in parallel into three bit planes. The planes are
+     * then unpacked into one byte per tile, 32 tiles at a time with AVX2, 16 with SSE2 or 8 without either,
+     * so a lookup is a single load.
+     */
+    class GainMap
+    {
+        /**
+         * @brief Bit k of the count of every tile.
+         */
+        std::array<Bitboard, 3> count_bits{};
+
+        alignas(32) std::array<uint8_t, Bitboard::CAPACITY> gains{};
+
+    public:
+        /**
+         * @brief Counts the targets around every tile.
+         *
+         * @param layout layout of the board
+         * @param targets gems to count
+         */
+        void compute(BoardLayout const &layout, Bitboard const &targets);
+
+        /**
+         * @brief Counts the opponent's gems around every tile, the gems a move into the tile by the player
+         * to move would capture.
+         */
+        void compute(Board const &board)
+        {
+            compute(board.get_layout(), board.tiles_of(other_player(board.current_player)));
+        }
+
+        /**
+         * @return int number of targets around the tile, for every tile of the board including occupied and void ones.
+         */
+        int operator[](int index) const
+        {
+            return gains[index];
+        }
+
+        /**
+         * @return Bitboard tiles with at least the specified number of targets around them.
+         */
+        Bitboard at_least(int count) const;
+    };
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <memory>
+#include <span>
 #include <ranges>
 #include <stdexcept>
 #include <tuple>
@@ -40,6 +43,55 @@ namespace hexx::common
         return {q, r, -q - r};
     }
 
+    /**
+     * @brief Cube direction vectors of the first ring of neighbours.
+     */
+    constexpr std::array<std::tuple<int, int, int>, 6> RING1_DIRECTIONS = {
+        // {q, r, s}
+        std::tuple{0, -1, 1},
+        {1, -1, 0},
+        {1, 0, -1},
+        {0, 1, -1},
+        {-1, 1, 0},
+        {-1, 0, 1},
+    };
+
+    /**
+     * @brief Cube direction vectors of the second ring of neighbours.
+     */
+    constexpr std::array<std::tuple<int, int, int>, 12> RING2_DIRECTIONS = {
+        // {q, r, s}
+        std::tuple{0, -2, 2},
+        {1, -2, 1},
+        {2, -2, 0},
+        {2, -1, -1},
+        {2, 0, -2},
+        {1, 1, -2},
+        {0, 2, -2},
+        {-1, 2, -1},
+        {-2, 2, 0},
+        {-2, 1, 1},
+        {-2, 0, 2},
+        {-1, -1, 2},
+    };
+
+    /**
+     * @brief Describes how HexMap treats tiles of type T. Specialize it to mark tiles that are not a part of the map.
+     *
+     * @tparam T type of the tile
+     */
+    template <class T>
+    struct HexTileTraits
+    {
+        /**
+         * @return true if the tile is not a part of the map and should be skipped by adjacency tables.
+         */
+        static constexpr bool is_void(T const &)
+        {
+            return false;
+        }
+    };
+
     /**
      * @brief Represents a hexagonal tile grid. The grid representation is derived from a square grid, with every odd column shifted (also known as "odd-q" layout)
      *
@@ -48,9 +100,60 @@ namespace hexx::common
     template <class T>
     class HexMap
     {
+        /**
+         * @brief Flat indices of neighbouring tiles, stored per tile in CSR form.
+         */
+        struct Adjacency
+        {
+            std::vector<int> ring1_offsets;
+            std::vector<int> ring1_indices;
+            std::vector<int> ring2_offsets;
+            std::vector<int> ring2_indices;
+        };
+
         int width{};
         int height{};
         std::vector<T> tiles{};
+        mutable std::shared_ptr<const Adjacency> adjacency{};
+
+        template <size_t N>
+        void build_ring(std::array<std::tuple<int, int, int>, N> const &directions,
+                        std::vector<int> &offsets, std::vector<int> &indices) const
+        {
+            offsets.reserve(tiles.size() + 1);
+
+            for (auto tile = cbegin(); tile != cend(); tile++)
+            {
+                offsets.push_back(indices.size());
+
+                if (HexTileTraits<T>::is_void(*tile))
+                    continue;
+
+                for (const auto [dq, dr, ds] : directions)
+                {
+                    auto other = tile.relative_cube(dq, dr, ds);
+                    if (other == cend() || HexTileTraits<T>::is_void(*other))
+                        continue;
+
+                    indices.push_back(other.index());
+                }
+            }
+
+            offsets.push_back(indices.size());
+        }
+
+        Adjacency const &get_adjacency() const
+        {
+            if (!adjacency)
+            {
+                auto table = std::make_shared<Adjacency>();
+                build_ring(RING1_DIRECTIONS, table->ring1_offsets, table->ring1_indices);
+                build_ring(RING2_DIRECTIONS, table->ring2_offsets, table->ring2_indices);
+                adjacency = std::move(table);
+            }
+
+            return *adjacency;
+        }
 
     public:
         class ConstFaceIterator;
@@ -75,6 +178,11 @@ namespace hexx::common
             FaceIterator(FaceIterator const &other) : map(other.map), pos(other.pos) {}
             FaceIterator(HexMap<T> *map, int pos) : map(map), pos(pos) {}
 
+            int index() const
+            {
+                return pos;
+            }
+
             int face_x() const
             {
                 return pos % map->width;
@@ -205,6 +313,11 @@ namespace hexx::common
             ConstFaceIterator(ConstFaceIterator const &other) : map(other.map), pos(other.pos) {}
             ConstFaceIterator(const HexMap<T> *map, int pos) : map(map), pos(pos) {}
 
+            int index() const
+            {
+                return pos;
+            }
+
             int face_x() const
             {
                 return pos % map->width;
@@ -317,11 +430,13 @@ namespace hexx::common
 
         HexMap(HexMap const &other) : width(other.width),
                                       height(other.height),
-                                      tiles(other.tiles) {}
+                                      tiles(other.tiles),
+                                      adjacency(other.adjacency) {}
 
         HexMap(HexMap &&other) : width(other.width),
                                  height(other.height),
-                                 tiles(std::move(other.tiles)) {}
+                                 tiles(std::move(other.tiles)),
+                                 adjacency(std::move(other.adjacency)) {}
 
         HexMap(int width, int height, std::initializer_list<T> tiles) : width(width), height(height), tiles(tiles)
         {
@@ -344,6 +459,7 @@ namespace hexx::common
             this->width = other.width;
             this->height = other.height;
             this->tiles = other.tiles;
+            this->adjacency = other.adjacency;
             return *this;
         }
 
@@ -352,6 +468,7 @@ namespace hexx::common
             this->width = other.width;
             this->height = other.height;
             this->tiles = std::move(other.tiles);
+            this->adjacency = std::move(other.adjacency);
             return *this;
         }
 
@@ -391,6 +508,71 @@ namespace hexx::common
             return ConstFaceIterator{this, y * width + x};
         }
 
+        /**
+         * @brief Returns the tile at flat index (y * width + x), without bounds checking.
+         *
+         * @param index flat index of the tile
+         * @return T& reference to the tile
+         */
+        T &operator[](int index)
+        {
+            return tiles[index];
+        }
+
+        /**
+         * @brief Returns the tile at flat index (y * width + x), without bounds checking.
+         *
+         * @param index flat index of the tile
+         * @return T const& reference to the tile
+         */
+        T const &operator[](int index) const
+        {
+            return tiles[index];
+        }
+
+        /**
+         * @brief Returns flat indices of tiles at distance 1 from the specified tile, in RING1_DIRECTIONS order.
+         * Out of bounds and void tiles are skipped. The table is built on first use and cached,
+         * call invalidate_adjacency() after changing which tiles are void.
+         *
+         * @param index flat index of the tile
+         * @return std::span<const int> indices of neighbouring tiles
+         */
+        std::span<const int> ring1_indices(int index) const
+        {
+            auto const &table = get_adjacency();
+            return std::span{table.ring1_indices}.subspan(table.ring1_offsets[index], table.ring1_offsets[index + 1] - table.ring1_offsets[index]);
+        }
+
+        /**
+         * @brief Returns flat indices of tiles at distance 2 from the specified tile, in RING2_DIRECTIONS order.
+         * Out of bounds and void tiles are skipped.
+         *
+         * @param index flat index of the tile
+         * @return std::span<const int> indices of tiles in the second ring
+         */
+        std::span<const int> ring2_indices(int index) const
+        {
+            auto const &table = get_adjacency();
+            return std::span{table.ring2_indices}.subspan(table.ring2_offsets[index], table.ring2_offsets[index + 1] - table.ring2_offsets[index]);
+        }
+
+        /**
+         * @brief Builds the adjacency tables now instead of on first use, e.g. before the map is shared between threads.
+         */
+        void build_adjacency() const
+        {
+            get_adjacency();
+        }
+
+        /**
+         * @brief Drops the cached adjacency tables, they will be rebuilt on next use.
+         */
+        void invalidate_adjacency()
+        {
+            adjacency.reset();
+        }
+
         int get_width() const
         {
             return width;
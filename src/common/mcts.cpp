@@ -0,0 +1,347 @@
+#include "mcts.h"
+#include "gain_map.h"
+#include "rng.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+using namespace hexx::common;
+
+enum NodeState : uint8_t
+{
+    LEAF,
+    EXPANDING,
+    EXPANDED,
+    TERMINAL,
+};
+
+// a leaf is expanded once it has been visited this many times, so the tree grows by about one node per playout
+constexpr uint32_t EXPAND_THRESHOLD = 1;
+
+// playouts that take longer than this are scored by the gem count at that point
+constexpr int MAX_PLAYOUT_PLIES = 400;
+
+Mcts::Mcts(size_t capacity) : pool(std::make_unique<Node[]>(capacity)), capacity(capacity)
+{
+    if (capacity < 1)
+    {
+        throw std::invalid_argument("MCTS node pool must hold at least the root");
+    }
+}
+
+bool Mcts::should_stop() const
+{
+    if (stop_requested.load(std::memory_order_relaxed))
+        return true;
+
+    if (limits.playouts != 0 && playouts.load(std::memory_order_relaxed) >= limits.playouts)
+        return true;
+
+    return limits.time.count() != 0 && std::chrono::steady_clock::now() - start_time >= limits.time;
+}
+
+bool Mcts::expand(Node &node, Board const &board)
+{
+    uint8_t expected = LEAF;
+    if (!node.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    MoveList<MAX_MOVES> moves;
+    board.generate_moves(moves);
+
+    if (moves.empty())
+    {
+        if (board.game_ended() || !board.any_move(other_player(board.current_player)))
+        {
+            node.state.store(TERMINAL, std::memory_order_release);
+            return false;
+        }
+
+        moves.push_back(PASS_MOVE);
+    }
+
+    const auto first = node_count.fetch_add(moves.size(), std::memory_order_relaxed);
+    if (first + moves.size() > capacity)
+    {
+        // the pool is full, the node stays a leaf and playouts start from here
+        node.state.store(LEAF, std::memory_order_release);
+        return false;
+    }
+
+    // unvisited children are tried in order, so put the greedy choices first
+    GainMap gains;
+    gains.compute(board);
+
+    std::stable_sort(moves.begin(), moves.end(),
+                     [&](Move const &a, Move const &b)
+                     {
+                         if (a == PASS_MOVE || b == PASS_MOVE)
+                             return false;
+                         return gains[a.to] > gains[b.to];
+                     });
+
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        auto &child = pool[first + i];
+        child.move = moves[i];
+        child.state.store(LEAF, std::memory_order_relaxed);
+        child.child_count.store(0, std::memory_order_relaxed);
+        child.first_child.store(0, std::memory_order_relaxed);
+        child.visits.store(0, std::memory_order_relaxed);
+        child.score.store(0, std::memory_order_relaxed);
+        child.virtual_loss.store(0, std::memory_order_relaxed);
+    }
+
+    node.first_child.store(first, std::memory_order_relaxed);
+    node.child_count.store(moves.size(), std::memory_order_relaxed);
+    node.state.store(EXPANDED, std::memory_order_release);
+
+    return true;
+}
+
+uint32_t Mcts::select_child(Node const &node) const
+{
+    const auto first = node.first_child.load(std::memory_order_relaxed);
+    const auto count = node.child_count.load(std::memory_order_relaxed);
+    const auto parent_visits = node.visits.load(std::memory_order_relaxed) + node.virtual_loss.load(std::memory_order_relaxed);
+    const auto log_visits = std::log(std::max<double>(parent_visits, 1.0));
+
+    uint32_t best_child = first;
+    double best_value = -std::numeric_limits<double>::infinity();
+
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        auto const &child = pool[i];
+
+        // a virtual loss counts as a visit without a win, steering other threads away from this path
+        const auto visits = child.visits.load(std::memory_order_relaxed) + child.virtual_loss.load(std::memory_order_relaxed);
+        if (visits == 0)
+        {
+            return i;
+        }
+
+        const auto win_rate = child.score.load(std::memory_order_relaxed) / (2.0 * visits);
+        const auto value = win_rate + exploration * std::sqrt(log_visits / visits);
+
+        if (value > best_value)
+        {
+            best_value = value;
+            best_child = i;
+        }
+    }
+
+    return best_child;
+}
+
+void Mcts::apply(Board &board, Move const &move, std::vector<Step> &steps)
+{
+    if (move == PASS_MOVE)
+    {
+        board.current_player = other_player(board.current_player);
+        steps.push_back({.record = {}, .pass = true});
+    }
+    else
+    {
+        steps.push_back({.record = board.make_move(move.from, move.to), .pass = false});
+    }
+}
+
+void Mcts::undo(Board &board, std::vector<Step> &steps)
+{
+    while (!steps.empty())
+    {
+        const auto &step = steps.back();
+
+        if (step.pass)
+            board.current_player = other_player(board.current_player);
+        else
+            board.unmake_move(step.record);
+
+        steps.pop_back();
+    }
+}
+
+int Mcts::playout(Board &board, std::vector<Step> &steps, std::mt19937_64 &gen)
+{
+    MoveList<MAX_MOVES> moves;
+
+    for (int ply = 0; ply < MAX_PLAYOUT_PLIES && !board.game_ended(); ply++)
+    {
+        board.generate_moves(moves);
+
+        if (moves.empty())
+        {
+            apply(board, PASS_MOVE, steps);
+
+            if (!board.any_move())
+                break;
+
+            continue;
+        }
+
+        // like ai_play: take the move capturing the most gems, a random one if nothing can be captured
+        GainMap gains;
+        gains.compute(board);
+
+        Move best_move = random_choice(moves, gen);
+        int best_captures = 0;
+        int ties = 0;
+
+        for (const auto &move : moves)
+        {
+            const auto captures = gains[move.to];
+
+            if (captures > best_captures)
+            {
+                best_captures = captures;
+                best_move = move;
+                ties = 1;
+            }
+            else if (captures == best_captures && captures > 0 && std::uniform_int_distribution<int>(0, ties++)(gen) == 0)
+            {
+                best_move = move;
+            }
+        }
+
+        apply(board, best_move, steps);
+    }
+
+    return board.ruby_score - board.pearl_score;
+}
+
+void Mcts::worker(Board const &root_board)
+{
+    Board board = root_board;
+    std::mt19937_64 gen{std::random_device{}()};
+    std::vector<Step> steps;
+    std::vector<std::pair<uint32_t, Player>> path;
+
+    steps.reserve(MAX_PLAYOUT_PLIES + 64);
+    path.reserve(64);
+
+    while (!should_stop())
+    {
+        path.clear();
+        uint32_t index = 0;
+
+        for (;;)
+        {
+            auto &node = pool[index];
+            auto state = node.state.load(std::memory_order_acquire);
+
+            if (state == LEAF && (index == 0 || node.visits.load(std::memory_order_relaxed) >= EXPAND_THRESHOLD) &&
+                node_count.load(std::memory_order_relaxed) < capacity && expand(node, board))
+            {
+                state = EXPANDED;
+            }
+
+            if (state != EXPANDED)
+                break;
+
+            const auto child = select_child(node);
+            pool[child].virtual_loss.fetch_add(1, std::memory_order_relaxed);
+            path.push_back({child, board.current_player});
+            apply(board, pool[child].move, steps);
+            index = child;
+        }
+
+        const auto margin = playout(board, steps, gen);
+        undo(board, steps);
+
+        pool[0].visits.fetch_add(1, std::memory_order_relaxed);
+
+        for (const auto &[node_index, mover] : path)
+        {
+            auto &node = pool[node_index];
+            const auto mover_margin = mover == Player::Ruby ? margin : -margin;
+
+            node.visits.fetch_add(1, std::memory_order_relaxed);
+            node.score.fetch_add(mover_margin > 0 ? 2 : mover_margin == 0 ? 1 : 0, std::memory_order_relaxed);
+            node.virtual_loss.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        playouts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+MctsResult Mcts::run(Board const &board, MctsLimits const &limits)
+{
+    if (limits.playouts == 0 && limits.time.count() == 0)
+    {
+        throw std::invalid_argument("MCTS needs a playout or time limit");
+    }
+
+    if (board.game_ended())
+    {
+        throw std::runtime_error("the game is over!");
+    }
+
+    if (!board.any_move())
+    {
+        throw std::runtime_error("there's no possible moves!");
+    }
+
+    this->limits = limits;
+    start_time = std::chrono::steady_clock::now();
+    playouts.store(0, std::memory_order_relaxed);
+
+    auto &root = pool[0];
+    root.state.store(LEAF, std::memory_order_relaxed);
+    root.visits.store(0, std::memory_order_relaxed);
+    root.score.store(0, std::memory_order_relaxed);
+    root.virtual_loss.store(0, std::memory_order_relaxed);
+    node_count.store(1, std::memory_order_relaxed);
+
+    if (!expand(root, board))
+    {
+        throw std::runtime_error("MCTS node pool is too small for the root moves");
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++)
+    {
+        workers.emplace_back([this, &board]()
+                             { worker(board); });
+    }
+
+    worker(board);
+
+    for (auto &thread : workers)
+    {
+        thread.join();
+    }
+
+    MctsResult result;
+    uint32_t best_visits = 0;
+
+    const auto first = root.first_child.load(std::memory_order_relaxed);
+    const auto count = root.child_count.load(std::memory_order_relaxed);
+
+    result.best_move = pool[first].move;
+
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        const auto visits = pool[i].visits.load(std::memory_order_relaxed);
+
+        if (visits > best_visits)
+        {
+            best_visits = visits;
+            result.best_move = pool[i].move;
+            result.win_rate = pool[i].score.load(std::memory_order_relaxed) / (2.0 * visits);
+        }
+    }
+
+    result.playouts = playouts.load(std::memory_order_relaxed);
+    result.nodes = std::min(node_count.load(std::memory_order_relaxed), capacity);
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+
+    // cleared only now, so a stop requested just before run() started isn't lost
+    stop_requested.store(false, std::memory_order_relaxed);
+
+    return result;
+}
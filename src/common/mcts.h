@@ -0,0 +1,153 @@
+#pragma once
+
+#include "board.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace hexx::common
+{
+    /**
+     * @brief Limits of a single MCTS run. Zero means no limit, but at least one of them must be set.
+     */
+    struct MctsLimits
+    {
+        uint64_t playouts{0};
+        std::chrono::milliseconds time{0};
+    };
+
+    /**
+     * @brief Outcome of an MCTS run.
+     */
+    struct MctsResult
+    {
+        Move best_move{};
+
+        /**
+         * @brief Expected result of best_move for the player to move, 0 is a loss and 1 a win.
+         */
+        double win_rate{0.0};
+
+        uint64_t playouts{0};
+        size_t nodes{0};
+        std::chrono::milliseconds elapsed{0};
+    };
+
+    /**
+     * @brief Monte Carlo tree search (UCT) with capture-greedy playouts.
+     *
+     * Worker threads share one tree. Each thread walks the tree with a virtual loss on the nodes it
+     * passes, so the others spread over different branches. Nodes come from a fixed pool: once it is
+     * full, the tree stops growing and playouts start from the leaves. Statistics live in atomics,
+     * so threads only wait for each other on the node that one of them is expanding.
+     */
+    class Mcts
+    {
+        struct Node
+        {
+            /**
+             * @brief Move leading to this node, PASS_MOVE if the player had to pass.
+             */
+            Move move{};
+            std::atomic<uint8_t> state{0};
+            std::atomic<uint16_t> child_count{0};
+            std::atomic<uint32_t> first_child{0};
+            std::atomic<uint32_t> visits{0};
+
+            /**
+             * @brief Results of playouts through this node for the player who made the move, 2 per win and 1 per draw.
+             */
+            std::atomic<uint32_t> score{0};
+            std::atomic<uint32_t> virtual_loss{0};
+        };
+
+        struct Step
+        {
+            UndoRecord record;
+            bool pass;
+        };
+
+        std::unique_ptr<Node[]> pool{};
+        size_t capacity{0};
+        std::atomic<size_t> node_count{0};
+        std::atomic<uint64_t> playouts{0};
+        std::atomic<bool> stop_requested{false};
+        int threads{1};
+        double exploration{1.0};
+
+        MctsLimits limits{};
+        std::chrono::steady_clock::time_point start_time{};
+
+        bool should_stop() const;
+
+        bool expand(Node &node, Board const &board);
+
+        uint32_t select_child(Node const &node) const;
+
+        static void apply(Board &board, Move const &move, std::vector<Step> &steps);
+
+        static void undo(Board &board, std::vector<Step> &steps);
+
+        static int playout(Board &board, std::vector<Step> &steps, std::mt19937_64 &gen);
+
+        void worker(Board const &root_board);
+
+    public:
+        /**
+         * @brief Marks moves of a player who had no moves and passed the turn.
+         */
+        static constexpr Move PASS_MOVE{0xFF, 0xFF};
+
+        /**
+         * @brief Default size of the node pool.
+         */
+        static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+        /**
+         * @param capacity maximum number of tree nodes, bounds memory use
+         */
+        explicit Mcts(size_t capacity = DEFAULT_CAPACITY);
+
+        /**
+         * @brief Sets the number of worker threads.
+         *
+         * @param threads number of threads, at least 1
+         */
+        void set_threads(int threads)
+        {
+            this->threads = std::max(threads, 1);
+        }
+
+        /**
+         * @brief Sets the UCT exploration constant.
+         */
+        void set_exploration(double exploration)
+        {
+            this->exploration = exploration;
+        }
+
+        /**
+         * @brief Searches the position and returns the most visited move. The tree is rebuilt on every run.
+         *
+         * @param board position to search, left unchanged
+         * @param limits playout and time limits
+         * @return MctsResult the best move found so far when a limit was hit or stop() was called
+         * @throws runtime_error if the game is over or the player to move has no moves.
+         */
+        MctsResult run(Board const &board, MctsLimits const &limits);
+
+        /**
+         * @brief Asks a running search to return its current best move. Safe to call from another thread.
+         * If no search is running, the next run() returns almost immediately.
+         */
+        void stop()
+        {
+            stop_requested.store(true, std::memory_order_relaxed);
+        }
+    };
+}
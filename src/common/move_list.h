@@ -0,0 +1,103 @@
+#pragma once
+
+#include "bitboard.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace hexx::common
+{
+    /**
+     * @brief A move between two tiles, stored as flat tile indices.
+     */
+    struct Move
+    {
+        uint8_t from;
+        uint8_t to;
+
+        friend constexpr bool operator==(Move const &a, Move const &b) = default;
+    };
+
+    /**
+     * @brief Maximum number of moves starting from a single tile (6 clones and 12 jumps).
+     */
+    constexpr size_t MAX_MOVES_PER_TILE = 18;
+
+    /**
+     * @brief Maximum number of moves in a position as produced by Board::generate_moves:
+     * one clone and at most 12 jumps into every tile.
+     */
+    constexpr size_t MAX_MOVES = Bitboard::CAPACITY * 13;
+
+    /**
+     * @brief Fixed-capacity list of moves, meant to live on the stack so move generation doesn't allocate.
+     *
+     * @tparam Capacity maximum number of moves
+     */
+    template <size_t Capacity>
+    class MoveList
+    {
+        std::array<Move, Capacity> moves;
+        size_t count{0};
+
+    public:
+        using value_type = Move;
+        using reference = Move &;
+        using const_reference = Move const &;
+        using iterator = Move *;
+        using const_iterator = Move const *;
+
+        MoveList() {}
+
+        void push_back(Move const &move)
+        {
+            moves[count++] = move;
+        }
+
+        void clear()
+        {
+            count = 0;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        Move &operator[](size_t index)
+        {
+            return moves[index];
+        }
+
+        Move const &operator[](size_t index) const
+        {
+            return moves[index];
+        }
+
+        Move *begin()
+        {
+            return moves.data();
+        }
+
+        Move *end()
+        {
+            return moves.data() + count;
+        }
+
+        Move const *begin() const
+        {
+            return moves.data();
+        }
+
+        Move const *end() const
+        {
+            return moves.data() + count;
+        }
+    };
+}
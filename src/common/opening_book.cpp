@@ -0,0 +1,240 @@
+#include "opening_book.h"
+#include "byte_utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace hexx::common;
+
+constexpr static uint32_t MAGIC_NUMBER = 0x26306B00;
+constexpr static uint16_t VERSION = 1;
+constexpr static size_t HEADER_SIZE = 16;
+constexpr static size_t ENTRY_SIZE = 16;
+
+static uint16_t load_uint16(uint8_t const *bytes)
+{
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t load_uint32(uint8_t const *bytes)
+{
+    return static_cast<uint32_t>(load_uint16(bytes)) | (static_cast<uint32_t>(load_uint16(bytes + 2)) << 16);
+}
+
+static uint64_t load_uint64(uint8_t const *bytes)
+{
+    return static_cast<uint64_t>(load_uint32(bytes)) | (static_cast<uint64_t>(load_uint32(bytes + 4)) << 32);
+}
+
+OpeningBook::OpeningBook(std::string const &path)
+{
+#ifdef _WIN32
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        file_handle = nullptr;
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(HEADER_SIZE))
+    {
+        close();
+        throw std::runtime_error("Not an opening book: " + path);
+    }
+
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const auto view = mapping_handle ? MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        close();
+        throw std::runtime_error("Failed to map file: " + path);
+    }
+
+    data = static_cast<uint8_t const *>(view);
+    data_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(HEADER_SIZE))
+    {
+        ::close(fd);
+        throw std::runtime_error("Not an opening book: " + path);
+    }
+
+    const auto view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (view == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map file: " + path);
+    }
+
+    data = static_cast<uint8_t const *>(view);
+    data_size = static_cast<size_t>(info.st_size);
+#endif
+
+    entry_count = load_uint32(data + 8);
+
+    if (load_uint32(data) != MAGIC_NUMBER || load_uint16(data + 4) != VERSION || load_uint16(data + 6) != ENTRY_SIZE ||
+        data_size < HEADER_SIZE + entry_count * ENTRY_SIZE)
+    {
+        close();
+        throw std::runtime_error("Not an opening book: " + path);
+    }
+}
+
+OpeningBook::~OpeningBook()
+{
+    close();
+}
+
+void OpeningBook::close()
+{
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping_handle)
+        CloseHandle(mapping_handle);
+    if (file_handle)
+        CloseHandle(file_handle);
+
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+#else
+    if (data)
+        munmap(const_cast<uint8_t *>(data), data_size);
+#endif
+
+    data = nullptr;
+    data_size = 0;
+    entry_count = 0;
+}
+
+std::shared_ptr<const OpeningBook> OpeningBook::open_default()
+{
+    try
+    {
+        return std::make_shared<const OpeningBook>(DEFAULT_BOOK_PATH);
+    }
+    catch (std::exception &e)
+    {
+        // no book, the AI searches every move
+        return nullptr;
+    }
+}
+
+std::vector<uint8_t> OpeningBook::serialize(std::vector<BookEntry> entries)
+{
+    std::ranges::stable_sort(entries, {}, &BookEntry::key);
+
+    ByteWriter writer;
+    writer.write_uint32(MAGIC_NUMBER);
+    writer.write_uint16(VERSION);
+    writer.write_uint16(ENTRY_SIZE);
+    writer.write_uint32(entries.size());
+    writer.write_uint32(0);
+
+    for (const auto &entry : entries)
+    {
+        writer.write_uint64(entry.key);
+        writer.write_uint8(entry.move.from);
+        writer.write_uint8(entry.move.to);
+        writer.write_uint16(entry.weight);
+        writer.write_int16(entry.score);
+        writer.write_uint16(0);
+    }
+
+    return std::move(writer.data);
+}
+
+BookEntry OpeningBook::entry_at(size_t index) const
+{
+    const auto bytes = data + HEADER_SIZE + index * ENTRY_SIZE;
+
+    return BookEntry{
+        .key = load_uint64(bytes),
+        .move = {bytes[8], bytes[9]},
+        .weight = load_uint16(bytes + 10),
+        .score = static_cast<int16_t>(load_uint16(bytes + 12)),
+    };
+}
+
+std::vector<BookEntry> OpeningBook::probe(uint64_t key) const
+{
+    // lower bound of the key
+    size_t low = 0;
+    size_t high = entry_count;
+
+    while (low < high)
+    {
+        const auto middle = low + (high - low) / 2;
+
+        if (load_uint64(data + HEADER_SIZE + middle * ENTRY_SIZE) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    std::vector<BookEntry> entries;
+
+    for (auto i = low; i < entry_count; i++)
+    {
+        auto entry = entry_at(i);
+        if (entry.key != key)
+            break;
+
+        entries.push_back(entry);
+    }
+
+    return entries;
+}
+
+std::optional<Move> OpeningBook::choose(Board const &board, std::mt19937_64 &gen) const
+{
+    auto entries = probe(board.hash());
+    if (entries.empty())
+        return std::nullopt;
+
+    MoveList<MAX_MOVES> moves;
+    board.generate_moves(moves);
+
+    std::erase_if(entries, [&](BookEntry const &entry)
+                  { return entry.weight == 0 || std::ranges::find(moves, entry.move) == moves.end(); });
+
+    if (entries.empty())
+        return std::nullopt;
+
+    uint32_t total = 0;
+    for (const auto &entry : entries)
+    {
+        total += entry.weight;
+    }
+
+    auto pick = std::uniform_int_distribution<uint32_t>(0, total - 1)(gen);
+    for (const auto &entry : entries)
+    {
+        if (pick < entry.weight)
+            return entry.move;
+
+        pick -= entry.weight;
+    }
+
+    return entries.back().move;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace hexx::common
+{
+    /**
+     * @brief Book file looked up by the AI, relative to the working directory like scores.dat.
+     */
+    constexpr char const *DEFAULT_BOOK_PATH = "book.dat";
+
+    /**
+     * @brief A book move of a position.
+     */
+    struct BookEntry
+    {
+        /**
+         * @brief Board::hash() of the position the move is played in.
+         */
+        uint64_t key;
+        Move move;
+
+        /**
+         * @brief Relative chance of picking the move among the moves of its position.
+         */
+        uint16_t weight;
+
+        /**
+         * @brief Search score of the move when the book was built, for the player making it.
+         */
+        int16_t score;
+    };
+
+    /**
+     * @brief Read-only opening book, memory-mapped from a file built by hexxagon_book.
+     *
+     * The file is a 16-byte header followed by 16-byte entries sorted by key, all little-endian:
+     *
+     * - header: magic (u32), version (u16), entry size (u16), entry count (u32), reserved (u32)
+     * - entry: key (u64), move origin (u8), move destination (u8), weight (u16), score (i16), reserved (u16)
+     *
+     * Opening only checks the header, lookups binary-search the mapped entries in place,
+     * so neither loading nor memory use grow with the size of the book.
+     */
+    class OpeningBook
+    {
+        uint8_t const *data{nullptr};
+        size_t data_size{0};
+        size_t entry_count{0};
+
+#ifdef _WIN32
+        void *file_handle{nullptr};
+        void *mapping_handle{nullptr};
+#endif
+
+        BookEntry entry_at(size_t index) const;
+
+        void close();
+
+    public:
+        OpeningBook() = default;
+
+        /**
+         * @brief Maps a book file.
+         *
+         * @param path path to the file
+         * @throws std::runtime_error if the file could not be mapped or isn't a valid book
+         */
+        explicit OpeningBook(std::string const &path);
+
+        OpeningBook(OpeningBook const &) = delete;
+
+        OpeningBook &operator=(OpeningBook const &) = delete;
+
+        ~OpeningBook();
+
+        /**
+         * @brief Maps the book at DEFAULT_BOOK_PATH.
+         *
+         * @return std::shared_ptr<const OpeningBook> the book, or null if there's no valid book file
+         */
+        static std::shared_ptr<const OpeningBook> open_default();
+
+        /**
+         * @brief Serializes entries into the book file format, sorting them by key.
+         *
+         * @param entries the entries, in any order
+         * @return std::vector<uint8_t> contents of the file
+         */
+        static std::vector<uint8_t> serialize(std::vector<BookEntry> entries);
+
+        /**
+         * @return size_t number of entries in the book.
+         */
+        size_t size() const
+        {
+            return entry_count;
+        }
+
+        /**
+         * @brief Looks up the book moves of a position.
+         *
+         * @param key hash of the position
+         * @return std::vector<BookEntry> the moves, empty if the position isn't in the book
+         */
+        std::vector<BookEntry> probe(uint64_t key) const;
+
+        /**
+         * @brief Picks a book move for the player to move, at random by weight. Moves that aren't legal in the
+         * position, which can only come from a hash collision, are skipped.
+         *
+         * @param board the position
+         * @param gen random number generator
+         * @return std::optional<Move> the move, or nothing if the position isn't in the book
+         */
+        std::optional<Move> choose(Board const &board, std::mt19937_64 &gen) const;
+    };
+}
@@ -19,4 +19,21 @@ namespace hexx::common
         std::uniform_int_distribution<> dis(0, container.size() - 1);
         return container[dis(gen)];
     }
+
+    /**
+     * @brief Picks a random element from a container using the provided generator.
+     * Unlike the overload above it doesn't touch shared state, so it can be used from multiple threads.
+     *
+     * @tparam T a container type
+     * @tparam G a random number generator type
+     * @param container the container to pick from
+     * @param gen the generator to use
+     * @return T::reference a reference to the picked element
+     */
+    template <class T, class G>
+    typename T::reference random_choice(T &container, G &gen)
+    {
+        std::uniform_int_distribution<size_t> dis(0, container.size() - 1);
+        return container[dis(gen)];
+    }
 }
\ No newline at end of file
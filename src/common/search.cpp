@@ -0,0 +1,384 @@
+#include "search.h"
+#include "gain_map.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+using namespace hexx::common;
+
+constexpr int SCORE_INFINITE = SCORE_WIN * 2;
+
+int hexx::common::evaluate_material(Board const &board)
+{
+    const auto margin = board.ruby_score - board.pearl_score;
+    return board.current_player == Player::Ruby ? margin : -margin;
+}
+
+int Search::terminal_score(Board const &board, int ply)
+{
+    const auto margin = evaluate_material(board);
+
+    if (margin > 0)
+        return SCORE_WIN + margin - ply;
+    if (margin < 0)
+        return -SCORE_WIN + margin + ply;
+    return 0;
+}
+
+// win and loss scores depend on the distance from the root, the table stores them relative to the node
+static int score_to_table(int score, int ply)
+{
+    if (score >= SCORE_WIN_THRESHOLD)
+        return score + ply;
+    if (score <= -SCORE_WIN_THRESHOLD)
+        return score - ply;
+    return score;
+}
+
+static int score_from_table(int score, int ply)
+{
+    if (score >= SCORE_WIN_THRESHOLD)
+        return score - ply;
+    if (score <= -SCORE_WIN_THRESHOLD)
+        return score + ply;
+    return score;
+}
+
+bool Search::time_limited() const
+{
+    return limits.time.count() != 0 && (!limits.ponder || ponder_hit.load(std::memory_order_relaxed));
+}
+
+void Search::check_limits()
+{
+    if (stop_requested.load(std::memory_order_relaxed))
+    {
+        stopped = true;
+    }
+    else if (limits.nodes != 0 && nodes >= limits.nodes)
+    {
+        stopped = true;
+    }
+    else if (time_limited() && std::chrono::steady_clock::now() - start_time >= limits.time)
+    {
+        stopped = true;
+    }
+}
+
+void Search::order_moves(Board const &board, MoveList<MAX_MOVES> &moves, int ply, std::optional<Move> const &table_move) const
+{
+    const auto &layout = board.get_layout();
+    const auto has_pv_move = ply < previous_pv_length;
+
+    GainMap gains;
+    gains.compute(board);
+
+    std::array<int16_t, MAX_MOVES> keys;
+
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        const auto &move = moves[i];
+
+        if (table_move && move == *table_move)
+        {
+            keys[i] = INT16_MAX;
+            continue;
+        }
+
+        if (has_pv_move && move == previous_pv[ply])
+        {
+            keys[i] = INT16_MAX - 1;
+            continue;
+        }
+
+        // captures matter most, then clones over jumps since a jump leaves its origin empty
+        keys[i] = gains[move.to] * 2 + (layout.ring1(move.from).test(move.to) ? 1 : 0);
+    }
+
+    // stable insertion sort, keeps generator order between equal keys
+    for (size_t i = 1; i < moves.size(); i++)
+    {
+        const auto key = keys[i];
+        const auto move = moves[i];
+        auto j = i;
+
+        for (; j > 0 && keys[j - 1] < key; j--)
+        {
+            keys[j] = keys[j - 1];
+            moves[j] = moves[j - 1];
+        }
+
+        keys[j] = key;
+        moves[j] = move;
+    }
+}
+
+int Search::negamax(Board &board, int depth, int ply, int alpha, int beta)
+{
+    pv_length[ply] = ply;
+
+    if ((++nodes & 1023) == 0)
+        check_limits();
+
+    if (stopped)
+        return 0;
+
+    if (board.game_ended())
+        return terminal_score(board, ply);
+
+    if (depth <= 0 || ply >= MAX_PLY - 1)
+        return evaluator(board);
+
+    const auto alpha_original = alpha;
+    std::optional<Move> table_move{};
+
+    if (table)
+    {
+        if (const auto entry = table->probe(board.hash()))
+        {
+            table_move = entry->move;
+
+            // the root always searches, so there is a best move to report
+            if (ply > 0 && entry->depth >= depth)
+            {
+                const auto score = score_from_table(entry->score, ply);
+
+                if (entry->bound == Bound::Exact ||
+                    (entry->bound == Bound::Lower && score >= beta) ||
+                    (entry->bound == Bound::Upper && score <= alpha))
+                {
+                    return score;
+                }
+            }
+        }
+    }
+
+    MoveList<MAX_MOVES> moves;
+    board.generate_moves(moves);
+
+    if (moves.empty())
+    {
+        // mirror Board::next_player: the turn passes to the opponent, the game is over if they can't move either
+        board.current_player = other_player(board.current_player);
+        const auto score = board.any_move() ? -negamax(board, depth - 1, ply + 1, -beta, -alpha)
+                                            : -terminal_score(board, ply);
+        board.current_player = other_player(board.current_player);
+
+        return score;
+    }
+
+    order_moves(board, moves, ply, table_move);
+
+    int best_score = -SCORE_INFINITE;
+    Move best_move = moves[0];
+
+    for (const auto &move : moves)
+    {
+        const auto record = board.make_move(move.from, move.to);
+        const auto score = -negamax(board, depth - 1, ply + 1, -beta, -alpha);
+        board.unmake_move(record);
+
+        if (stopped)
+            return 0;
+
+        if (score <= best_score)
+            continue;
+
+        best_score = score;
+        best_move = move;
+
+        if (score > alpha)
+        {
+            alpha = score;
+
+            pv_table[ply][ply] = move;
+            std::copy(pv_table[ply + 1].begin() + ply + 1, pv_table[ply + 1].begin() + pv_length[ply + 1], pv_table[ply].begin() + ply + 1);
+            pv_length[ply] = std::max(pv_length[ply + 1], ply + 1);
+
+            if (alpha >= beta)
+                break;
+        }
+    }
+
+    if (table)
+    {
+        const auto bound = best_score >= beta             ? Bound::Lower
+                           : best_score > alpha_original ? Bound::Exact
+                                                         : Bound::Upper;
+
+        table->store(board.hash(), {
+                                       .move = best_move,
+                                       .score = score_to_table(best_score, ply),
+                                       .depth = depth,
+                                       .bound = bound,
+                                   });
+    }
+
+    return best_score;
+}
+
+void Search::prepare(SearchLimits const &limits, std::chrono::steady_clock::time_point start)
+{
+    this->limits = limits;
+    stopped = false;
+    nodes = 0;
+    start_time = start;
+    previous_pv_length = 0;
+}
+
+void Search::iterate(Board &position, int first_depth, SearchResult &result)
+{
+    const auto max_depth = std::clamp(limits.depth, 1, MAX_PLY - 1);
+
+    for (int depth = first_depth; depth <= max_depth; depth++)
+    {
+        const auto score = negamax(position, depth, 0, -SCORE_INFINITE, SCORE_INFINITE);
+
+        if (stopped)
+            break;
+
+        result.score = score;
+        result.depth = depth;
+
+        // an iteration that ends without a line keeps the move of the previous one
+        if (pv_length[0] > 0)
+        {
+            result.pv.assign(pv_table[0].begin(), pv_table[0].begin() + pv_length[0]);
+            result.best_move = result.pv.front();
+        }
+
+        previous_pv = pv_table[0];
+        previous_pv_length = pv_length[0];
+
+        // the next iteration takes several times longer than this one, don't start it if it can't finish
+        const auto elapsed = std::chrono::steady_clock::now() - start_time;
+        if (time_limited() && elapsed * 2 >= limits.time)
+            break;
+    }
+}
+
+bool Search::solve_endgame(Board const &position, SearchResult &result)
+{
+    EndgameSolver solver;
+    const auto solved = solver.solve(position, [this]()
+                                     {
+                                         nodes += 1024;
+                                         check_limits();
+
+                                         // if the solver can't finish, leave half of the time to iterative deepening
+                                         return stopped || (time_limited() && (std::chrono::steady_clock::now() - start_time) * 2 >= limits.time);
+                                     });
+
+    if (solved.aborted)
+        return false;
+
+    result.best_move = solved.best_move;
+    result.score = !solved.decided     ? solved.margin
+                   : solved.margin > 0 ? SCORE_WIN + solved.margin
+                                       : -SCORE_WIN + solved.margin;
+    result.depth = solved.depth;
+    result.pv = {solved.best_move};
+
+    return true;
+}
+
+void Search::search_threads(Board const &board, Board &position, SearchResult &result)
+{
+    // lazy SMP: helpers search the same root and share work only through the transposition table.
+    // odd helpers start one ply deeper, so the threads spread over neighbouring depths.
+    std::vector<std::unique_ptr<Search>> helpers;
+    std::vector<SearchResult> helper_results(threads - 1, result);
+    std::vector<std::thread> workers;
+
+    // helpers run until the main thread stops them
+    auto helper_limits = limits;
+    helper_limits.nodes = 0;
+    helper_limits.time = std::chrono::milliseconds(0);
+    helper_limits.ponder = false;
+
+    for (int i = 1; i < threads; i++)
+    {
+        auto helper = std::make_unique<Search>(evaluator);
+        helper->table = table;
+        helper->prepare(helper_limits, start_time);
+
+        workers.emplace_back(
+            [helper = helper.get(), &board, &helper_result = helper_results[i - 1], first_depth = 1 + i % 2]()
+            {
+                Board helper_position = board;
+                helper->iterate(helper_position, first_depth, helper_result);
+            });
+
+        helpers.push_back(std::move(helper));
+    }
+
+    iterate(position, 1, result);
+
+    for (auto &helper : helpers)
+    {
+        helper->stop();
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (size_t i = 0; i < helpers.size(); i++)
+    {
+        nodes += helpers[i]->nodes;
+
+        if (helper_results[i].depth > result.depth)
+        {
+            result.best_move = helper_results[i].best_move;
+            result.score = helper_results[i].score;
+            result.depth = helper_results[i].depth;
+            result.pv = std::move(helper_results[i].pv);
+        }
+    }
+}
+
+SearchResult Search::run(Board const &board, SearchLimits const &limits)
+{
+    prepare(limits, std::chrono::steady_clock::now());
+
+    if (table)
+    {
+        table->new_search();
+    }
+
+    if (board.game_ended())
+    {
+        throw std::runtime_error("the game is over!");
+    }
+
+    Board position = board;
+
+    MoveList<MAX_MOVES> moves;
+    position.generate_moves(moves);
+
+    if (moves.empty())
+    {
+        throw std::runtime_error("there's no possible moves!");
+    }
+
+    // used if not even the first iteration completes
+    SearchResult result;
+    result.best_move = moves[0];
+    result.pv = {moves[0]};
+
+    if (position.get_empty_count() > endgame_empties || !solve_endgame(position, result))
+    {
+        search_threads(board, position, result);
+    }
+
+    result.nodes = nodes;
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+
+    // cleared only now, so a stop or ponderhit requested just before run() started isn't lost
+    stop_requested.store(false, std::memory_order_relaxed);
+    ponder_hit.store(false, std::memory_order_relaxed);
+
+    return result;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "board.h"
+#include "endgame.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace hexx::common
+{
+    /**
+     * @brief Evaluates a position from the point of view of the player to move. Higher is better.
+     * Scores must stay well within (-SCORE_WIN, SCORE_WIN).
+     */
+    using Evaluator = std::function<int(Board const &)>;
+
+    /**
+     * @brief Base score of a won game. Final scores add the gem margin and prefer shorter wins.
+     */
+    constexpr int SCORE_WIN = 10000;
+
+    /**
+     * @brief Deepest ply the search can reach, including passes.
+     */
+    constexpr int MAX_PLY = 64;
+
+    /**
+     * @brief Scores at least this far from zero are final game results.
+     */
+    constexpr int SCORE_WIN_THRESHOLD = SCORE_WIN - 2 * Bitboard::CAPACITY;
+
+    /**
+     * @brief Default evaluation: difference between the gem counts of the player to move and the opponent.
+     */
+    int evaluate_material(Board const &board);
+
+    /**
+     * @brief Limits of a single search. Zero means no limit for nodes and time.
+     */
+    struct SearchLimits
+    {
+        int depth{4};
+        uint64_t nodes{0};
+        std::chrono::milliseconds time{0};
+
+        /**
+         * @brief Search on the opponent's time: the time limit is ignored until Search::ponderhit() is called,
+         * then it counts from the start of the search.
+         */
+        bool ponder{false};
+    };
+
+    /**
+     * @brief Limits used by the computer player.
+     */
+    constexpr SearchLimits AI_SEARCH_LIMITS{
+        .depth = MAX_PLY,
+        .nodes = 0,
+        .time = std::chrono::milliseconds(300),
+    };
+
+    /**
+     * @brief Outcome of a search, taken from the last fully searched depth.
+     */
+    struct SearchResult
+    {
+        Move best_move{};
+        int score{0};
+        int depth{0};
+        uint64_t nodes{0};
+        std::chrono::milliseconds elapsed{0};
+
+        /**
+         * @brief Principal variation, starting with best_move. Passes end the line.
+         */
+        std::vector<Move> pv{};
+    };
+
+    /**
+     * @brief Negamax alpha-beta search with iterative deepening and principal variation tracking.
+     * The search plays moves in place on a copy of the board, using make_move/unmake_move.
+     */
+    class Search
+    {
+        Evaluator evaluator;
+        std::shared_ptr<TranspositionTable> table{};
+        int threads{1};
+        int endgame_empties{DEFAULT_ENDGAME_EMPTIES};
+        SearchLimits limits{};
+        std::atomic<bool> stop_requested{false};
+        std::atomic<bool> ponder_hit{false};
+        bool stopped{false};
+        uint64_t nodes{0};
+        std::chrono::steady_clock::time_point start_time{};
+
+        std::array<std::array<Move, MAX_PLY>, MAX_PLY> pv_table{};
+        std::array<int, MAX_PLY> pv_length{};
+        std::array<Move, MAX_PLY> previous_pv{};
+        int previous_pv_length{0};
+
+        void prepare(SearchLimits const &limits, std::chrono::steady_clock::time_point start);
+
+        void iterate(Board &position, int first_depth, SearchResult &result);
+
+        bool time_limited() const;
+
+        void check_limits();
+
+        void order_moves(Board const &board, MoveList<MAX_MOVES> &moves, int ply, std::optional<Move> const &table_move) const;
+
+        int negamax(Board &board, int depth, int ply, int alpha, int beta);
+
+        bool solve_endgame(Board const &position, SearchResult &result);
+
+        void search_threads(Board const &board, Board &position, SearchResult &result);
+
+    public:
+        explicit Search(Evaluator evaluator = evaluate_material) : evaluator(std::move(evaluator)) {}
+
+        /**
+         * @brief Sets the transposition table used by the search. It can be kept between searches
+         * to reuse work from previous moves. Null disables the table.
+         *
+         * @param table the table to use
+         */
+        void set_transposition_table(std::shared_ptr<TranspositionTable> table)
+        {
+            this->table = std::move(table);
+        }
+
+        /**
+         * @brief Sets the number of threads used by the search. Helper threads search the same root
+         * at staggered depths and share results through the transposition table (lazy SMP),
+         * so more than one thread only helps when a table is set.
+         *
+         * @param threads number of threads, at least 1
+         */
+        void set_threads(int threads)
+        {
+            this->threads = std::max(threads, 1);
+        }
+
+        /**
+         * @brief Sets how few empty tiles make the search hand the position to EndgameSolver.
+         * If the solver runs out of half of the time, iterative deepening takes over.
+         *
+         * @param empties the threshold, 0 disables the solver
+         */
+        void set_endgame_empties(int empties)
+        {
+            endgame_empties = std::max(empties, 0);
+        }
+
+        /**
+         * @brief Searches the position for the best move of the player to move.
+         *
+         * @param board position to search, left unchanged
+         * @param limits depth, node and time limits
+         * @return SearchResult result of the deepest iteration completed by any thread, nodes of all threads
+         * @throws runtime_error if the game is over or the player to move has no moves.
+         */
+        SearchResult run(Board const &board, SearchLimits const &limits);
+
+        /**
+         * @brief Asks a running search to finish as soon as possible. Safe to call from another thread.
+         * If no search is running, the next run() returns almost immediately.
+         */
+        void stop()
+        {
+            stop_requested.store(true, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Tells a pondering search that the expected move was played, so its time limit starts to apply.
+         * Safe to call from another thread. If no search is running, it applies to the next run().
+         */
+        void ponderhit()
+        {
+            ponder_hit.store(true, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Score of a finished game from the point of view of the player to move.
+         *
+         * @param board finished position
+         * @param ply distance from the root, used to prefer faster wins
+         */
+        static int terminal_score(Board const &board, int ply);
+    };
+}
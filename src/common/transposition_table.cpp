@@ -0,0 +1,148 @@
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace hexx::common;
+
+// data layout, from the lowest bit:
+// 8 bits move origin, 8 bits move destination, 16 bits score, 8 bits depth,
+// 2 bits bound, 1 bit "has move", 5 bits unused, 8 bits generation
+constexpr int SCORE_SHIFT = 16;
+constexpr int DEPTH_SHIFT = 32;
+constexpr int BOUND_SHIFT = 40;
+constexpr int HAS_MOVE_SHIFT = 42;
+constexpr int GENERATION_SHIFT = 48;
+
+uint64_t TranspositionTable::pack(Entry const &entry, uint8_t generation)
+{
+    uint64_t data = 0;
+
+    if (entry.move)
+    {
+        data |= static_cast<uint64_t>(entry.move->from);
+        data |= static_cast<uint64_t>(entry.move->to) << 8;
+        data |= 1ULL << HAS_MOVE_SHIFT;
+    }
+
+    data |= static_cast<uint64_t>(static_cast<uint16_t>(static_cast<int16_t>(entry.score))) << SCORE_SHIFT;
+    data |= static_cast<uint64_t>(static_cast<uint8_t>(std::clamp(entry.depth, 0, 255))) << DEPTH_SHIFT;
+    data |= static_cast<uint64_t>(entry.bound) << BOUND_SHIFT;
+    data |= static_cast<uint64_t>(generation) << GENERATION_SHIFT;
+
+    return data;
+}
+
+TranspositionTable::Entry TranspositionTable::unpack(uint64_t data)
+{
+    Entry entry{
+        .move = std::nullopt,
+        .score = static_cast<int16_t>(static_cast<uint16_t>(data >> SCORE_SHIFT)),
+        .depth = static_cast<uint8_t>(data >> DEPTH_SHIFT),
+        .bound = static_cast<Bound>((data >> BOUND_SHIFT) & 3),
+    };
+
+    if ((data >> HAS_MOVE_SHIFT) & 1)
+    {
+        entry.move = Move{static_cast<uint8_t>(data), static_cast<uint8_t>(data >> 8)};
+    }
+
+    return entry;
+}
+
+uint8_t TranspositionTable::generation_of(uint64_t data)
+{
+    return static_cast<uint8_t>(data >> GENERATION_SHIFT);
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    bucket_count = std::bit_floor(std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Bucket), 1));
+    buckets.reset();
+    buckets = std::make_unique<Bucket[]>(bucket_count);
+    mask = bucket_count - 1;
+    generation.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucket_count; i++)
+    {
+        for (auto &slot : buckets[i].slots)
+        {
+            slot.checked_key.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    generation.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::new_search()
+{
+    generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::optional<TranspositionTable::Entry> TranspositionTable::probe(uint64_t key) const
+{
+    auto const &bucket = buckets[key & mask];
+
+    for (auto const &slot : bucket.slots)
+    {
+        const auto data = slot.data.load(std::memory_order_relaxed);
+        const auto checked_key = slot.checked_key.load(std::memory_order_relaxed);
+
+        if (data != 0 && (checked_key ^ data) == key)
+        {
+            return unpack(data);
+        }
+    }
+
+    return std::nullopt;
+}
+
+void TranspositionTable::store(uint64_t key, Entry const &entry)
+{
+    auto &bucket = buckets[key & mask];
+    auto &deep = bucket.slots[0];
+    auto &recent = bucket.slots[1];
+    const auto current_generation = generation.load(std::memory_order_relaxed);
+
+    const auto deep_data = deep.data.load(std::memory_order_relaxed);
+    const auto deep_key = deep.checked_key.load(std::memory_order_relaxed) ^ deep_data;
+    const auto deep_entry = unpack(deep_data);
+    const auto replace_deep = deep_key == key ||
+                              deep_entry.bound == Bound::None ||
+                              deep_entry.depth <= entry.depth ||
+                              generation_of(deep_data) != current_generation;
+
+    auto &slot = replace_deep ? deep : recent;
+    const auto slot_data = slot.data.load(std::memory_order_relaxed);
+    const auto slot_key = slot.checked_key.load(std::memory_order_relaxed) ^ slot_data;
+
+    auto stored = entry;
+    if (!stored.move && slot_key == key && slot_data != 0)
+    {
+        stored.move = unpack(slot_data).move;
+    }
+
+    const auto data = pack(stored, current_generation);
+    slot.checked_key.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+
+    // the position moved to the depth-preferred slot, don't keep a stale copy around
+    if (replace_deep)
+    {
+        const auto recent_data = recent.data.load(std::memory_order_relaxed);
+        if ((recent.checked_key.load(std::memory_order_relaxed) ^ recent_data) == key)
+        {
+            recent.checked_key.store(0, std::memory_order_relaxed);
+            recent.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "move_list.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace hexx::common
+{
+    /**
+     * @brief Kind of score stored in the transposition table.
+     *
+     * - None: the slot is empty
+     * - Upper: the real score is at most the stored one (no move raised alpha)
+     * - Lower: the real score is at least the stored one (beta cutoff)
+     * - Exact: the stored score is exact
+     */
+    enum class Bound : uint8_t
+    {
+        None,
+        Upper,
+        Lower,
+        Exact
+    };
+
+    /**
+     * @brief Fixed-size hash table of search results, keyed by Board::hash().
+     *
+     * Every bucket holds two 16-byte entries: a depth-preferred one, replaced only by deeper results
+     * or results from a newer search, and an always-replace one that takes everything else.
+     *
+     * The table can be shared by search threads without locking. Each entry stores its key XOR-ed with
+     * its data, so a torn entry written by two threads at once fails verification and is treated as a miss.
+     */
+    class TranspositionTable
+    {
+    public:
+        /**
+         * @brief Unpacked contents of an entry.
+         */
+        struct Entry
+        {
+            std::optional<Move> move;
+            int score;
+            int depth;
+            Bound bound;
+        };
+
+    private:
+        /**
+         * @brief Packed entry: key XOR data, and score, depth, bound, generation and best move in one word.
+         */
+        struct Slot
+        {
+            std::atomic<uint64_t> checked_key{0};
+            std::atomic<uint64_t> data{0};
+        };
+
+        static_assert(sizeof(Slot) == 16);
+
+        struct alignas(32) Bucket
+        {
+            std::array<Slot, 2> slots{};
+        };
+
+        std::unique_ptr<Bucket[]> buckets{};
+        size_t bucket_count{0};
+        uint64_t mask{0};
+        std::atomic<uint8_t> generation{0};
+
+        static uint64_t pack(Entry const &entry, uint8_t generation);
+
+        static Entry unpack(uint64_t data);
+
+        static uint8_t generation_of(uint64_t data);
+
+    public:
+        /**
+         * @brief Default size used by the AI, in megabytes.
+         */
+        static constexpr size_t DEFAULT_SIZE_MB = 16;
+
+        /**
+         * @param megabytes size of the table, rounded down to a power of two number of buckets.
+         */
+        explicit TranspositionTable(size_t megabytes = DEFAULT_SIZE_MB);
+
+        /**
+         * @brief Reallocates the table, dropping all entries. Must not run concurrently with a search.
+         *
+         * @param megabytes size of the table, rounded down to a power of two number of buckets.
+         */
+        void resize(size_t megabytes);
+
+        /**
+         * @brief Drops all entries. Must not run concurrently with a search.
+         */
+        void clear();
+
+        /**
+         * @brief Marks the start of a new search. Entries from older searches are replaced first.
+         */
+        void new_search();
+
+        /**
+         * @brief Looks up a position.
+         *
+         * @param key hash of the position
+         * @return std::optional<Entry> the stored entry, if any
+         */
+        std::optional<Entry> probe(uint64_t key) const;
+
+        /**
+         * @brief Stores a search result. Scores must fit in 16 bits and depth in 8 bits.
+         *
+         * @param key hash of the position
+         * @param entry result to store, a missing move keeps the previously stored move of this position
+         */
+        void store(uint64_t key, Entry const &entry);
+
+        /**
+         * @return size_t size of the table in bytes.
+         */
+        size_t size_bytes() const
+        {
+            return bucket_count * sizeof(Bucket);
+        }
+    };
+}
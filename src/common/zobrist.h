@@ -0,0 +1,51 @@
+#pragma once
+
+#include "bitboard.h"
+
+#include <array>
+#include <cstdint>
+
+namespace hexx::common
+{
+    namespace detail
+    {
+        constexpr uint64_t splitmix64(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        struct ZobristKeys
+        {
+            std::array<std::array<uint64_t, 4>, Bitboard::CAPACITY> tiles{};
+            uint64_t side{};
+        };
+
+        constexpr ZobristKeys make_zobrist_keys()
+        {
+            ZobristKeys keys{};
+            uint64_t state = 0x4865787861676F6EULL;
+
+            for (auto &tile : keys.tiles)
+            {
+                for (auto &key : tile)
+                {
+                    key = splitmix64(state);
+                }
+            }
+
+            keys.side = splitmix64(state);
+
+            return keys;
+        }
+    }
+
+    /**
+     * @brief Random keys for Zobrist hashing of positions, indexed by flat tile index and TileState.
+     * Generated at compile time from a fixed seed, so hashes are stable between runs and builds
+     * and can be stored in files.
+     */
+    constexpr detail::ZobristKeys ZOBRIST_KEYS = detail::make_zobrist_keys();
+}
@@ -31,7 +31,7 @@ void Button::draw(Context &ctx)
     ctx.res.font.builder()
         .with_pos(rect.x + (rect.w - text_width) / 2, rect.y + (rect.h - text_height) / 2)
         .with_text(text)
-        .draw();
+        .draw(ctx.batch);
 }
 
 void Button::mouse_down(Context &ctx, int x, int y)
@@ -11,12 +11,13 @@ namespace hexx::gui
         SDL_Renderer *render;
 
         ResourceInstances res;
+        SpriteBatch batch;
         SceneManager manager;
         bool debug;
         bool running;
 
         Context(SDL_Renderer *render)
-            : render{render}, res{render}, manager{render}, debug{false}, running{true}
+            : render{render}, res{render}, batch{render}, manager{render}, debug{false}, running{true}
         {
         }
 
@@ -25,8 +25,10 @@ namespace hexx::gui
          * @brief Runs the game loop
          *
          * @param callback The callback to call each tick. If the callback returns false, the loop will stop.
+         * @param idle Called while no tick is due. It may block until there's something to do, like waiting for
+         * input, and returns true if it did; the loop then ticks right away instead of catching up the time it slept.
          */
-        void run(std::function<bool()> callback)
+        void run(std::function<bool()> callback, std::function<bool()> idle = nullptr)
         {
             for (;;)
             {
@@ -49,6 +51,12 @@ namespace hexx::gui
                 {
                     last_tick = lt;
                 }
+                else if (idle && idle())
+                {
+                    last_tick = (get_nano_monotonic() - start_tick);
+                    next_tick = last_tick;
+                    continue;
+                }
                 else
                 {
                     std::this_thread::sleep_for(std::chrono::microseconds(1000));
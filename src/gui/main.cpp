@@ -143,12 +143,28 @@ int main()
 
             if (ctx.debug)
             {
-                ctx.res.font.builder().with_pos(2, 2).with_color(Color(0, 255, 0)).with_text("fps: " + std::to_string(last_fps)).draw();
+                ctx.res.font.builder().with_pos(2, 2).with_color(Color(0, 255, 0)).with_format("fps: %d", last_fps).draw(ctx.batch);
+                ctx.batch.flush();
             }
 
             SDL_RenderPresent(render);
 
             return ctx.running;
+        },
+        [&]()
+        {
+            // the fps counter measures the loop, so it keeps ticking while shown
+            const auto idle_time = ctx.debug ? 0 : ctx.manager.idle_time();
+            if (idle_time == 0)
+                return false;
+
+            // the last frame stays on screen; sleep until input or until a scene's next scheduled change
+            if (idle_time == NEVER_DIRTY)
+                SDL_WaitEvent(nullptr);
+            else
+                SDL_WaitEventTimeout(nullptr, static_cast<int>(idle_time));
+
+            return true;
         });
 
     SDL_DestroyRenderer(render);
@@ -1,7 +1,11 @@
 #include "render.h"
 
 #include <stdexcept>
+#include <algorithm>
 #include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
 
 #include <SDL.h>
 
@@ -80,6 +84,9 @@ void Texture::initialize_render_target(SDL_Renderer *renderer, int width, int he
     {
         throw std::runtime_error("failed to create texture: " + std::string(SDL_GetError()));
     }
+
+    this->width = width;
+    this->height = height;
 }
 
 void Texture::initialize_from_bmp_buffer(SDL_Renderer *renderer, std::span<uint8_t> const &data)
@@ -101,6 +108,8 @@ void Texture::initialize_from_bmp_buffer(SDL_Renderer *renderer, std::span<uint8
     {
         throw std::runtime_error("failed to create texture: " + std::string(SDL_GetError()));
     }
+
+    SDL_QueryTexture(inner, nullptr, nullptr, &width, &height);
 }
 
 static constexpr SDL_Rect to_sdl_rect(Rect const &rect)
@@ -108,7 +117,7 @@ static constexpr SDL_Rect to_sdl_rect(Rect const &rect)
     return SDL_Rect{rect.x, rect.y, rect.w, rect.h};
 }
 
-static constexpr SDL_BlendMode to_sdl_blend_mode(BlendMode blend_mode)
+static SDL_BlendMode to_sdl_blend_mode(BlendMode blend_mode)
 {
     switch (blend_mode)
     {
@@ -116,7 +125,12 @@ static constexpr SDL_BlendMode to_sdl_blend_mode(BlendMode blend_mode)
         return SDL_BLENDMODE_BLEND;
     case BlendMode::Add:
         return SDL_BLENDMODE_ADD;
+    case BlendMode::Premultiplied:
+        return SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                          SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
     }
+
+    return SDL_BLENDMODE_BLEND;
 }
 
 void Texture::draw(Rect const &src_rect, Rect const &dest_rect, BlendMode blend_mode) const
@@ -131,16 +145,90 @@ void Texture::draw(Rect const &src_rect, Rect const &dest_rect, BlendMode blend_
     SDL_RenderCopy(renderer, inner, &sdl_src, &sdl_drc);
 }
 
-void TextRenderer::draw_text(int x, int y, std::string const &text, Color const &color) const
+static_assert(sizeof(SpriteBatch::Vertex) == sizeof(SDL_Vertex));
+static_assert(offsetof(SpriteBatch::Vertex, color) == offsetof(SDL_Vertex, color));
+static_assert(offsetof(SpriteBatch::Vertex, u) == offsetof(SDL_Vertex, tex_coord));
+
+SpriteBatch::Group &SpriteBatch::group_for(Texture const &texture, BlendMode blend_mode)
+{
+    for (size_t i = 0; i < used_groups; i++)
+    {
+        if (groups[i].texture == &texture && groups[i].blend_mode == blend_mode)
+            return groups[i];
+    }
+
+    // reuse a group left from an earlier frame, so its vertex buffer keeps its capacity
+    if (used_groups == groups.size())
+        groups.push_back({});
+
+    auto &group = groups[used_groups++];
+    group.texture = &texture;
+    group.blend_mode = blend_mode;
+    return group;
+}
+
+void SpriteBatch::add(Texture const &texture, Rect const &src_rect, Rect const &dst_rect, BlendMode blend_mode, Color const &color)
+{
+    if (!texture.inner)
+        return;
+
+    auto &vertices = group_for(texture, blend_mode).vertices;
+
+    const auto left = static_cast<float>(dst_rect.x);
+    const auto top = static_cast<float>(dst_rect.y);
+    const auto right = static_cast<float>(dst_rect.x + dst_rect.w);
+    const auto bottom = static_cast<float>(dst_rect.y + dst_rect.h);
+
+    const auto u0 = static_cast<float>(src_rect.x) / texture.width;
+    const auto v0 = static_cast<float>(src_rect.y) / texture.height;
+    const auto u1 = static_cast<float>(src_rect.x + src_rect.w) / texture.width;
+    const auto v1 = static_cast<float>(src_rect.y + src_rect.h) / texture.height;
+
+    vertices.push_back({left, top, color, u0, v0});
+    vertices.push_back({right, top, color, u1, v0});
+    vertices.push_back({left, bottom, color, u0, v1});
+    vertices.push_back({right, bottom, color, u1, v1});
+}
+
+void SpriteBatch::flush()
+{
+    for (size_t i = 0; i < used_groups; i++)
+    {
+        auto &group = groups[i];
+        const auto &vertices = group.vertices;
+        const auto quads = vertices.size() / 4;
+
+        for (auto quad = indices.size() / 6; quad < quads; quad++)
+        {
+            const auto first = static_cast<int>(quad * 4);
+            indices.insert(indices.end(), {first, first + 1, first + 2, first + 2, first + 1, first + 3});
+        }
+
+        if (quads > 0)
+        {
+            constexpr auto stride = static_cast<int>(sizeof(Vertex));
+
+            SDL_SetTextureBlendMode(group.texture->inner, to_sdl_blend_mode(group.blend_mode));
+            SDL_RenderGeometryRaw(renderer, group.texture->inner,
+                                  &vertices[0].x, stride,
+                                  reinterpret_cast<SDL_Color const *>(&vertices[0].color), stride,
+                                  &vertices[0].u, stride,
+                                  static_cast<int>(vertices.size()),
+                                  indices.data(), static_cast<int>(quads * 6), sizeof(int));
+        }
+
+        group.vertices.clear();
+    }
+
+    used_groups = 0;
+}
+
+void TextRenderer::draw_text(SpriteBatch &batch, int x, int y, std::string_view text, Color const &color) const
 {
     auto pos_x = x;
     auto pos_y = y;
-    SDL_Rect src_rect{0, 0, font_info.char_width, font_info.char_height};
-    SDL_Rect dst_rect{0, 0, font_info.char_width, font_info.char_height};
-
-    SDL_SetTextureBlendMode(texture->inner, SDL_BLENDMODE_BLEND);
-    SDL_SetTextureColorMod(texture->inner, color.r, color.g, color.b);
-    SDL_SetTextureAlphaMod(texture->inner, color.a);
+    Rect src_rect{0, 0, font_info.char_width, font_info.char_height};
+    Rect dst_rect{0, 0, font_info.char_width, font_info.char_height};
 
     for (auto c : text)
     {
@@ -165,14 +253,11 @@ void TextRenderer::draw_text(int x, int y, std::string const &text, Color const
             dst_rect.x = pos_x;
             dst_rect.y = pos_y;
 
-            SDL_RenderCopy(texture->renderer, texture->inner, &src_rect, &dst_rect);
+            batch.add(*texture, src_rect, dst_rect, BlendMode::Alpha, color);
 
             pos_x += font_info.char_width;
         }
     }
-
-    SDL_SetTextureColorMod(texture->inner, 255, 255, 255);
-    SDL_SetTextureAlphaMod(texture->inner, 255);
 }
 
 TextBuilder TextRenderer::builder() const
@@ -180,6 +265,17 @@ TextBuilder TextRenderer::builder() const
     return TextBuilder(*this);
 }
 
+TextBuilder &TextBuilder::with_format(char const *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const auto length = std::vsnprintf(buffer.data(), buffer.size(), format, args);
+    va_end(args);
+
+    text = std::string_view(buffer.data(), length < 0 ? 0 : std::min<size_t>(length, buffer.size() - 1));
+    return *this;
+}
+
 void hexx::gui::fill_rect(SDL_Renderer *renderer, Rect const &rect, Color const &color)
 {
     const auto sdl_rect = to_sdl_rect(rect);
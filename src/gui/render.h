@@ -1,9 +1,12 @@
 #pragma once
 
 #include <span>
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "types.h"
 
@@ -16,13 +19,20 @@ extern "C"
 namespace hexx::gui
 {
     class Sprite;
+    class SpriteBatch;
     class TextRenderer;
     class TextBuilder;
 
     enum class BlendMode
     {
         Alpha,
-        Add
+        Add,
+
+        /**
+         * @brief Color is added as it is and the destination is kept by one minus the source alpha,
+         * for textures whose color is already multiplied by alpha, like a layer rendered with Add and Alpha.
+         */
+        Premultiplied
     };
 
     /**
@@ -60,10 +70,13 @@ namespace hexx::gui
     class Texture
     {
         friend class Sprite;
+        friend class SpriteBatch;
         friend class TextRenderer;
 
         SDL_Texture *inner{nullptr};
         SDL_Renderer *renderer{nullptr};
+        int width{0};
+        int height{0};
 
         void dispose();
 
@@ -110,6 +123,69 @@ namespace hexx::gui
         void draw(Rect const &src_rect, Rect const &dst_rect, BlendMode blend_mode = BlendMode::Alpha) const;
     };
 
+    /**
+     * @brief Collects textured quads and draws them with one SDL_RenderGeometryRaw call per texture and blend mode,
+     * instead of one SDL_RenderCopy per quad.
+     *
+     * Groups are drawn in the order they were first used and quads within a group in the order they were added,
+     * so quads of different groups don't keep their relative order. Anything drawn directly, and any change of
+     * the render target, must come after flush(). The buffers keep their capacity between frames.
+     */
+    class SpriteBatch
+    {
+    public:
+        /**
+         * @brief Same layout as the position, color and texture coordinates of SDL_Vertex.
+         */
+        struct Vertex
+        {
+            float x;
+            float y;
+            Color color;
+            float u;
+            float v;
+        };
+
+    private:
+        struct Group
+        {
+            Texture const *texture;
+            BlendMode blend_mode;
+            std::vector<Vertex> vertices;
+        };
+
+        SDL_Renderer *renderer;
+        std::vector<Group> groups{};
+        size_t used_groups{0};
+
+        /**
+         * @brief Two triangles per quad, shared by all groups.
+         */
+        std::vector<int> indices{};
+
+        Group &group_for(Texture const &texture, BlendMode blend_mode);
+
+    public:
+        explicit SpriteBatch(SDL_Renderer *renderer) : renderer(renderer) {}
+
+        /**
+         * @brief Queues a part of the texture to be drawn in the specified rectangle.
+         *
+         * @param texture the texture to draw from
+         * @param src_rect the source rectangle
+         * @param dst_rect the destination rectangle
+         * @param blend_mode the blending mode to use
+         * @param color color the texture is multiplied by
+         */
+        void add(Texture const &texture, Rect const &src_rect, Rect const &dst_rect,
+                 BlendMode blend_mode = BlendMode::Alpha, Color const &color = Color(255, 255, 255));
+
+        /**
+         * @brief Draws every queued quad and empties the batch.
+         */
+        void flush();
+    };
+
     /**
      * @brief Represents a sprite and provides methods to draw it.
      */
@@ -153,6 +229,19 @@ namespace hexx::gui
             texture->draw(rect, rect.with_pos(x, y), blend_mode);
         }
 
+        /**
+         * @brief Queue the sprite in a batch at the given position. The position is based on the top left corner of the sprite.
+         *
+         * @param batch the batch to add the sprite to.
+         * @param x position on the x axis.
+         * @param y position on the y axis.
+         * @param blend_mode the blending mode to use.
+         */
+        void draw(SpriteBatch &batch, int x, int y, BlendMode blend_mode = BlendMode::Alpha) const
+        {
+            batch.add(*texture, rect, rect.with_pos(x, y), blend_mode);
+        }
+
         /**
          * @brief Draw the sprite at the given position and size. The position is based on the center of the sprite.
          *
@@ -166,6 +255,21 @@ namespace hexx::gui
         {
             texture->draw(rect, {x, y, width, height}, blend_mode);
         }
+
+        /**
+         * @brief Queue the sprite in a batch at the given position and size. The position is based on the top left corner of the sprite.
+         *
+         * @param batch the batch to add the sprite to.
+         * @param x position on the x axis.
+         * @param y position on the y axis.
+         * @param width width of the sprite.
+         * @param height height of the sprite.
+         * @param blend_mode the blending mode to use.
+         */
+        void draw_scaled(SpriteBatch &batch, int x, int y, int width, int height, BlendMode blend_mode = BlendMode::Alpha) const
+        {
+            batch.add(*texture, rect, {x, y, width, height}, blend_mode);
+        }
     };
 
     /**
@@ -196,7 +300,16 @@ namespace hexx::gui
          */
         TextBuilder builder() const;
 
-        void draw_text(int x, int y, std::string const &text, Color const &color) const;
+        /**
+         * @brief Queues a quad for every glyph of the text, tinted with the color through the vertex colors.
+         *
+         * @param batch the batch to add the glyphs to.
+         * @param x position on the x axis.
+         * @param y position on the y axis.
+         * @param text the text to draw, '\n' starts a new line.
+         * @param color the color of the text.
+         */
+        void draw_text(SpriteBatch &batch, int x, int y, std::string_view text, Color const &color) const;
 
         /**
          * @brief Calculates the size of the given text.
@@ -204,23 +317,32 @@ namespace hexx::gui
          * @param text the text to calculate the size of.
          * @return std::pair<int, int> the size of the text.
          */
-        std::pair<int, int> get_text_size(std::string const &text) const
+        std::pair<int, int> get_text_size(std::string_view text) const
         {
-            return {font_info.char_width * text.size(), font_info.char_height};
+            return {font_info.char_width * static_cast<int>(text.size()), font_info.char_height};
         }
     };
 
+    /**
+     * @brief Builds a text to draw. The text is either borrowed from the caller or formatted into a buffer
+     * inside the builder, so drawing it doesn't allocate. A builder can't be copied, since the text may point
+     * into its own buffer.
+     */
     class TextBuilder
     {
         TextRenderer const &rend;
         int x{0};
         int y{0};
-        std::string text{};
+        std::string_view text{};
         Color color{255, 255, 255, 255};
+        std::array<char, 128> buffer{};
 
     public:
         TextBuilder(TextRenderer const &rend) : rend(rend) {}
 
+        TextBuilder(TextBuilder const &) = delete;
+        TextBuilder &operator=(TextBuilder const &) = delete;
+
         /**
          * @brief Sets the position of the text.
          *
@@ -236,28 +358,25 @@ namespace hexx::gui
         }
 
         /**
-         * @brief Sets the text to draw.
+         * @brief Sets the text to draw. The text isn't copied, so it must outlive the call to draw.
          *
          * @param text the text to draw
          * @return TextBuilder&
          */
-        TextBuilder &with_text(std::string const &text)
+        TextBuilder &with_text(std::string_view text)
         {
             this->text = text;
             return *this;
         }
 
         /**
-         * @brief Sets the text to draw.
+         * @brief Sets the text to draw from a printf-style format, written into the builder's buffer.
+         * Text longer than the buffer is cut off.
          *
-         * @param text the text to draw
+         * @param format the format string
          * @return TextBuilder&
          */
-        TextBuilder &with_text(std::string &&text)
-        {
-            this->text = std::move(text);
-            return *this;
-        }
+        TextBuilder &with_format(char const *format, ...);
 
         /**
          * @brief Sets the color of the text.
@@ -272,11 +391,21 @@ namespace hexx::gui
         }
 
         /**
-         * @brief Draws the text.
+         * @return std::pair<int, int> the size of the text set so far.
+         */
+        std::pair<int, int> get_size() const
+        {
+            return rend.get_text_size(text);
+        }
+
+        /**
+         * @brief Queues the text in a batch.
+         *
+         * @param batch the batch to add the glyphs to.
          */
-        void draw() const
+        void draw(SpriteBatch &batch) const
         {
-            rend.draw_text(x, y, text, color);
+            rend.draw_text(batch, x, y, text, color);
         }
     };
 
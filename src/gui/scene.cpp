@@ -3,6 +3,8 @@
 
 #include <SDL.h>
 
+#include <algorithm>
+
 using namespace hexx::gui;
 
 void SceneManager::tick(Context &ctx)
@@ -13,20 +15,55 @@ void SceneManager::tick(Context &ctx)
     }
 }
 
+size_t SceneManager::first_visible() const
+{
+    // scenes beneath an opaque one can't be seen; their back buffers wait until they're uncovered
+    for (auto i = scene_stack.size(); i-- > 0;)
+    {
+        if (scene_stack[i]->is_opaque())
+            return i;
+    }
+
+    return 0;
+}
+
+uint32_t SceneManager::idle_time() const
+{
+    auto result = NEVER_DIRTY;
+
+    for (auto i = first_visible(); i < scene_stack.size(); i++)
+    {
+        if (scene_stack[i]->is_dirty())
+            return 0;
+
+        result = std::min(result, scene_stack[i]->ms_until_dirty());
+    }
+
+    return result;
+}
+
 void SceneManager::draw(Context &ctx)
 {
-    for (auto &scene : scene_stack)
+    const auto visible = scene_stack.begin() + first_visible();
+
+    for (auto scene = visible; scene != scene_stack.end(); scene++)
     {
-        SDL_SetRenderTarget(renderer, scene->back_buffer->get_inner());
+        if (!(*scene)->is_dirty())
+            continue;
 
-        scene->draw(ctx);
+        SDL_SetRenderTarget(renderer, (*scene)->back_buffer->get_inner());
+
+        (*scene)->draw(ctx);
+        ctx.batch.flush();
 
         SDL_SetRenderTarget(renderer, nullptr);
+
+        (*scene)->redraw = false;
     }
 
-    for (auto &scene : scene_stack)
+    for (auto scene = visible; scene != scene_stack.end(); scene++)
     {
-        SDL_RenderCopy(renderer, scene->back_buffer->get_inner(), nullptr, nullptr);
+        SDL_RenderCopy(renderer, (*scene)->back_buffer->get_inner(), nullptr, nullptr);
     }
 }
 
@@ -34,6 +71,7 @@ void SceneManager::key_down(Context &ctx, int key)
 {
     if (!scene_stack.empty())
     {
+        scene_stack.back()->redraw = true;
         scene_stack.back()->key_down(ctx, key);
     }
 }
@@ -42,6 +80,7 @@ void SceneManager::key_up(Context &ctx, int key)
 {
     if (!scene_stack.empty())
     {
+        scene_stack.back()->redraw = true;
         scene_stack.back()->key_up(ctx, key);
     }
 }
@@ -50,6 +89,7 @@ void SceneManager::mouse_down(Context &ctx, uint8_t index, int x, int y)
 {
     if (!scene_stack.empty())
     {
+        scene_stack.back()->redraw = true;
         scene_stack.back()->mouse_down(ctx, index, x, y);
     }
 }
@@ -58,6 +98,7 @@ void SceneManager::mouse_up(Context &ctx, uint8_t index, int x, int y)
 {
     if (!scene_stack.empty())
     {
+        scene_stack.back()->redraw = true;
         scene_stack.back()->mouse_up(ctx, index, x, y);
     }
 }
@@ -66,6 +107,7 @@ void SceneManager::mouse_move(Context &ctx, int x, int y)
 {
     if (!scene_stack.empty())
     {
+        scene_stack.back()->redraw = true;
         scene_stack.back()->mouse_move(ctx, x, y);
     }
 }
@@ -74,6 +116,7 @@ void SceneManager::text_input(Context &ctx, std::string const &text)
 {
     if (!scene_stack.empty())
     {
+        scene_stack.back()->redraw = true;
         scene_stack.back()->text_input(ctx, text);
     }
 }
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 #include "render.h"
 
@@ -16,6 +17,11 @@ namespace hexx::gui
     static constexpr int DISPLAY_HEIGHT = 300;
     static constexpr int DISPLAY_SCALE = 2;
 
+    /**
+     * @brief Returned by SceneBase::ms_until_dirty and SceneManager::idle_time when nothing is scheduled.
+     */
+    static constexpr uint32_t NEVER_DIRTY = UINT32_MAX;
+
     struct Context;
 
     /**
@@ -33,8 +39,39 @@ namespace hexx::gui
          */
         std::shared_ptr<Texture> back_buffer{nullptr};
 
+        /**
+         * @brief Set while the back buffer doesn't show the scene as it is. The manager sets it when the scene
+         * is added and when it gets input, and clears it after drawing; a scene sets it when it changes otherwise.
+         */
+        bool redraw{true};
+
         virtual ~SceneBase() {}
 
+        /**
+         * @brief Whether the back buffer has to be drawn again. Scenes that animate override this.
+         */
+        virtual bool is_dirty() const
+        {
+            return redraw;
+        }
+
+        /**
+         * @brief For a clean scene, the milliseconds until it becomes dirty on its own, like the next step of
+         * a timed animation, or NEVER_DIRTY if only input changes it.
+         */
+        virtual uint32_t ms_until_dirty() const
+        {
+            return NEVER_DIRTY;
+        }
+
+        /**
+         * @brief Whether the scene covers the whole screen, so the scenes beneath it are neither drawn nor composited.
+         */
+        virtual bool is_opaque() const
+        {
+            return false;
+        }
+
         virtual void tick(Context &ctx) = 0;
 
         virtual void draw(Context &ctx) = 0;
@@ -61,6 +98,11 @@ namespace hexx::gui
         std::vector<std::unique_ptr<SceneBase>> scene_stack{};
         SDL_Renderer *renderer;
 
+        /**
+         * @return size_t index of the lowest visible scene: the topmost opaque one, or the bottom one.
+         */
+        size_t first_visible() const;
+
     public:
         SceneManager(SDL_Renderer *renderer) : renderer(renderer) {}
 
@@ -72,12 +114,21 @@ namespace hexx::gui
         void tick(Context &ctx);
 
         /**
-         * @brief Render the current scene.
+         * @brief Render the visible scenes: the topmost opaque one and those above it. Only the back buffers of
+         * dirty scenes are drawn again, the others are composited as they are.
          *
          * @param ctx The context of the current scene.
          */
         void draw(Context &ctx);
 
+        /**
+         * @brief Tells how long the loop can wait for input without ticking or drawing.
+         *
+         * @return uint32_t 0 if a visible scene is dirty, otherwise the milliseconds until one becomes dirty,
+         * NEVER_DIRTY if none will without input.
+         */
+        uint32_t idle_time() const;
+
         /**
          * @brief Handle key down events.
          *
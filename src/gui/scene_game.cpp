@@ -8,6 +8,8 @@
 
 #include <SDL.h>
 
+#include <algorithm>
+
 using namespace hexx::gui;
 using namespace hexx::common;
 using std::operator""s;
@@ -17,19 +19,167 @@ SceneGame::SceneGame() : SceneBase()
     board.reset(HexMap<TileState>{LEVEL1_TEMPLATE});
 }
 
-void SceneGame::tick(Context &ctx)
+void SceneGame::cancel_ai()
+{
+    ai.cancel();
+    ai_thinking = false;
+}
+
+void SceneGame::load(std::vector<uint8_t> const &data)
+{
+    cancel_ai();
+    board.deserialize(data);
+    board_layer_valid = false;
+    redraw = true;
+}
+
+bool SceneGame::computer_to_move() const
+{
+    // a finished game is scored in tick without asking the computer, which would find no move
+    return board.with_computer && board.current_player == Player::Pearl && !board.game_ended() && !board.no_moves_left();
+}
+
+bool SceneGame::is_dirty() const
+{
+    return redraw || SDL_GetTicks() / HUE_STEP_MS != drawn_hue_step;
+}
+
+uint32_t SceneGame::ms_until_dirty() const
+{
+    const auto until_hue_step = HUE_STEP_MS - SDL_GetTicks() % HUE_STEP_MS;
+
+    if (!computer_to_move())
+        return until_hue_step;
+
+    // tick only runs when the loop wakes up: right away to ask for the move, then often enough to pick it up
+    return ai_thinking ? std::min(until_hue_step, AI_POLL_MS) : 0;
+}
+
+std::pair<int, int> SceneGame::tile_position(int x, int y) const
+{
+    const auto offset_x = (400 - board.map.get_width() * 32) / 2;
+    const auto offset_y = (300 - board.map.get_height() * 32) / 2;
+
+    return {offset_x + x * 32, offset_y + y * 32 + ((x & 1) ? 16 : 0)};
+}
+
+void SceneGame::draw_tiles(Context &ctx, Bitboard tiles) const
+{
+    const auto width = board.map.get_width();
+    constexpr auto sprite_offset = (40 - 32) / 2;
+
+    tiles &= ~board.tiles_of(TileState::Void);
+
+    // every hexagon first, the batch draws them in one call before the gems
+    for (auto hexagons = tiles; hexagons.any();)
+    {
+        const auto index = hexagons.pop_lowest();
+        const auto [pos_x, pos_y] = tile_position(index % width, index / width);
+        ctx.res.hexagon.draw(ctx.batch, pos_x, pos_y, BlendMode::Add);
+    }
+
+    for (auto gems = tiles & ~board.tiles_of(TileState::Empty); gems.any();)
+    {
+        const auto index = gems.pop_lowest();
+        const auto [pos_x, pos_y] = tile_position(index % width, index / width);
+        const auto &sprite = board.tiles_of(Player::Ruby).test(index) ? ctx.res.ruby : ctx.res.pearl;
+        sprite.draw(ctx.batch, pos_x + sprite_offset, pos_y);
+    }
+}
+
+void SceneGame::update_board_layer(Context &ctx)
 {
-    if (board.with_computer && board.current_player == Player::Pearl)
+    const auto &ruby = board.tiles_of(Player::Ruby);
+    const auto &pearl = board.tiles_of(Player::Pearl);
+    const auto &void_tiles = board.tiles_of(TileState::Void);
+
+    if (!board_layer.get_inner())
+    {
+        board_layer.initialize_render_target(ctx.render, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        board_layer_valid = false;
+    }
+
+    // a different map also shows up as different void tiles
+    if (!(void_tiles == drawn_void))
+        board_layer_valid = false;
+
+    const auto changed = (ruby ^ drawn_ruby) | (pearl ^ drawn_pearl);
+    if (board_layer_valid && changed.none())
+        return;
+
+    ctx.batch.flush();
+    const auto previous_target = SDL_GetRenderTarget(ctx.render);
+    SDL_SetRenderTarget(ctx.render, board_layer.get_inner());
+
+    if (!board_layer_valid)
+    {
+        SDL_SetRenderDrawColor(ctx.render, 0, 0, 0, 0);
+        SDL_RenderClear(ctx.render);
+
+        draw_tiles(ctx, ruby | pearl | board.tiles_of(TileState::Empty));
+        ctx.batch.flush();
+    }
+    else
     {
-        board.clear_highlights();
-        const auto move = board.ai_play();
+        const auto width = board.map.get_width();
+
+        // hexagons of neighbouring columns overlap, so a cleared tile gets its neighbours' edges back too
+        for (auto dirty = changed; dirty.any();)
+        {
+            const auto index = dirty.pop_lowest();
+            const auto [pos_x, pos_y] = tile_position(index % width, index / width);
+            const SDL_Rect clip{pos_x, pos_y, 40, 32};
+
+            SDL_RenderSetClipRect(ctx.render, &clip);
+            SDL_SetRenderDrawBlendMode(ctx.render, SDL_BLENDMODE_NONE);
+            fill_rect(ctx.render, {pos_x, pos_y, 40, 32}, Color(0, 0, 0, 0));
 
-        board.selected_tile = move.from;
-        const auto [to_x, to_y] = move.to;
+            draw_tiles(ctx, Bitboard::bit(index) | board.get_layout().ring1(index));
+            ctx.batch.flush();
+        }
+
+        SDL_RenderSetClipRect(ctx.render, nullptr);
+    }
+
+    SDL_SetRenderTarget(ctx.render, previous_target);
+
+    drawn_ruby = ruby;
+    drawn_pearl = pearl;
+    drawn_void = void_tiles;
+    board_layer_valid = true;
+}
 
-        if (board.try_move(to_x, to_y))
+void SceneGame::tick(Context &ctx)
+{
+    if (computer_to_move())
+    {
+        if (!ai_thinking)
         {
-            board.next_player();
+            board.clear_highlights();
+            ai.request(board);
+            ai_thinking = true;
+            redraw = true;
+        }
+        else if (const auto result = ai.poll())
+        {
+            ai_thinking = false;
+            redraw = true;
+
+            const auto &move = result->move;
+            board.selected_tile = move.from;
+            const auto [to_x, to_y] = move.to;
+
+            if (board.try_move(to_x, to_y))
+            {
+                board.next_player();
+
+                // keep thinking while the player does, expecting the reply the search predicted
+                if (board.current_player == Player::Ruby && !board.game_ended())
+                {
+                    const auto &pv = result->search.pv;
+                    ai.ponder(board, pv.size() > 1 ? std::optional{pv[1]} : std::nullopt);
+                }
+            }
         }
     }
     else
@@ -61,7 +211,7 @@ void SceneGame::tick(Context &ctx)
         }
     }
 
-    if (board.game_ended())
+    if (board.game_ended() || board.no_moves_left())
     {
         HighScoreManager{}.add_score(board.ruby_score, board.pearl_score);
 
@@ -72,42 +222,19 @@ void SceneGame::tick(Context &ctx)
 
 void SceneGame::draw(Context &ctx)
 {
-    const auto clear_color = Color::from_hsl(SDL_GetTicks() / 30.0f, 0.3f, 0.25f, 1.0f);
+    drawn_hue_step = SDL_GetTicks() / HUE_STEP_MS;
+    const auto clear_color = Color::from_hsl(drawn_hue_step * HUE_STEP, 0.3f, 0.25f, 1.0f);
 
     SDL_SetRenderDrawColor(ctx.render, clear_color.r, clear_color.g, clear_color.b, clear_color.a);
     SDL_RenderClear(ctx.render);
 
-    const auto offset_x = (400 - board.map.get_width() * 32) / 2;
-    const auto offset_y = (300 - board.map.get_height() * 32) / 2;
-
-    for (auto tile = board.map.begin(); tile != board.map.end(); tile++)
-    {
-        if (*tile == TileState::Void)
-            continue;
-
-        const auto pos_x = offset_x + tile.face_x() * 32;
-        const auto pos_y = offset_y + tile.face_y() * 32 + ((tile.face_x() & 1) ? 16 : 0);
-
-        ctx.res.hexagon.draw(pos_x, pos_y, BlendMode::Add);
-
-        constexpr auto sprite_offset = (40 - 32) / 2;
-
-        if (*tile == TileState::Ruby)
-        {
-            ctx.res.ruby.draw(pos_x + sprite_offset, pos_y);
-        }
-        else if (*tile == TileState::Pearl)
-        {
-            ctx.res.pearl.draw(pos_x + sprite_offset, pos_y);
-        }
-    }
+    update_board_layer(ctx);
+    board_layer.draw({0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT}, {0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT}, BlendMode::Premultiplied);
 
     for (const auto &[x, y] : board.highlights)
     {
-        const auto pos_x = offset_x + x * 32;
-        const auto pos_y = offset_y + y * 32 + ((x & 1) ? 16 : 0);
-
-        ctx.res.highlight.draw(pos_x, pos_y);
+        const auto [pos_x, pos_y] = tile_position(x, y);
+        ctx.res.highlight.draw(ctx.batch, pos_x, pos_y);
     }
 
     ctx.res.font.builder()
@@ -115,19 +242,19 @@ void SceneGame::draw(Context &ctx)
         .with_text(board.current_player == Player::Ruby ? "This is Ruby's turn!"
                                                         : "This is Pearl's turn!")
         .with_color(board.current_player == Player::Ruby ? COLOR_RUBY : COLOR_PEARL)
-        .draw();
+        .draw(ctx.batch);
 
     ctx.res.font.builder()
         .with_pos(2, 12)
-        .with_text("Ruby: " + std::to_string(board.ruby_score))
+        .with_format("Ruby: %d", board.ruby_score)
         .with_color(COLOR_RUBY)
-        .draw();
+        .draw(ctx.batch);
 
     ctx.res.font.builder()
         .with_pos(2, 22)
-        .with_text("Pearl: " + std::to_string(board.pearl_score))
+        .with_format("Pearl: %d", board.pearl_score)
         .with_color(COLOR_PEARL)
-        .draw();
+        .draw(ctx.batch);
 
     // res.font.builder()
     //     .with_pos(4, (SDL_GetTicks() / 10) % 300)
@@ -138,16 +265,12 @@ void SceneGame::draw(Context &ctx)
 
 void SceneGame::mouse_down(Context &ctx, uint8_t index, int x, int y)
 {
-    const auto offset_x = (400 - board.map.get_width() * 32) / 2;
-    const auto offset_y = (300 - board.map.get_height() * 32) / 2;
-
     for (auto tile = board.map.begin(); tile != board.map.end(); tile++)
     {
         if (*tile == TileState::Void)
             continue;
 
-        const auto pos_x = offset_x + tile.face_x() * 32;
-        const auto pos_y = offset_y + tile.face_y() * 32 + ((tile.face_x() & 1) ? 16 : 0);
+        const auto [pos_x, pos_y] = tile_position(tile.face_x(), tile.face_y());
 
         Rect mouse_rect{pos_x + 7, pos_y, 26, 32};
         if (mouse_rect.contains(x, y))
@@ -181,6 +304,9 @@ void SceneGame::key_down(Context &ctx, SDL_Keycode key)
                     return;
                 }
 
+                // the save holds the position before the computer's move, so start that move over afterwards
+                cancel_ai();
+
                 try
                 {
                     auto data = board.serialize();
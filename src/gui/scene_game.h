@@ -1,6 +1,7 @@
 #pragma once
 
 #include "scene.h"
+#include <common/ai_worker.h>
 #include <common/board.h>
 
 namespace hexx::gui
@@ -14,6 +15,64 @@ namespace hexx::gui
     {
         std::pair<int, int> clicked_tile{-1, -1};
 
+        /**
+         * @brief Thinks for the computer player, so tick never waits for it, and ponders during the player's turn.
+         * Destroying the scene cancels the search.
+         */
+        common::AiWorker ai{};
+        bool ai_thinking{false};
+
+        void cancel_ai();
+
+        /**
+         * @brief Whether the computer plays the next move, so tick asks it for one or polls for its answer.
+         */
+        bool computer_to_move() const;
+
+        /**
+         * @brief The background hue moves a step of HUE_STEP degrees every HUE_STEP_MS milliseconds. A smaller
+         * step wouldn't change the 8-bit colour of the dim background, so the scene is clean in between.
+         */
+        static constexpr uint32_t HUE_STEP_MS = 60;
+        static constexpr float HUE_STEP = 2.0f;
+
+        /**
+         * @brief How often tick polls the computer's move while the scene is clean.
+         */
+        static constexpr uint32_t AI_POLL_MS = 15;
+
+        /**
+         * @brief Hue step of the background as it was last drawn.
+         */
+        uint32_t drawn_hue_step{0};
+
+        /**
+         * @brief Hexagons and gems, drawn in full once and then only where tiles changed, composited over the
+         * animated background whenever the scene is drawn. The drawn_* bitboards hold the tiles as they are in
+         * the layer.
+         */
+        Texture board_layer{};
+        common::Bitboard drawn_ruby{};
+        common::Bitboard drawn_pearl{};
+        common::Bitboard drawn_void{};
+        bool board_layer_valid{false};
+
+        /**
+         * @return std::pair<int, int> screen position of the hexagon of a tile.
+         */
+        std::pair<int, int> tile_position(int x, int y) const;
+
+        /**
+         * @brief Queues the hexagons and then the gems of the tiles.
+         */
+        void draw_tiles(Context &ctx, common::Bitboard tiles) const;
+
+        /**
+         * @brief Redraws the tiles that changed since the last frame into the board layer, or all of them
+         * after the board was replaced.
+         */
+        void update_board_layer(Context &ctx);
+
     public:
         common::Board board;
 
@@ -21,10 +80,32 @@ namespace hexx::gui
 
         virtual ~SceneGame() = default;
 
+        /**
+         * @brief Replaces the game with a saved one, cancelling the computer's move in progress.
+         *
+         * @param data serialized board
+         */
+        void load(std::vector<uint8_t> const &data);
+
         void tick(Context &ctx) override;
 
         void draw(Context &ctx) override;
 
+        /**
+         * @brief Dirty also when the background hue steps.
+         */
+        bool is_dirty() const override;
+
+        /**
+         * @brief Time until the next hue step, sooner while the computer's move has to be asked for or polled.
+         */
+        uint32_t ms_until_dirty() const override;
+
+        bool is_opaque() const override
+        {
+            return true;
+        }
+
         void mouse_down(Context &ctx, uint8_t index, int x, int y) override;
 
         void mouse_up(Context &ctx, uint8_t index, int x, int y) override;
@@ -32,33 +32,28 @@ void SceneGameOver::draw(Context &ctx)
     SDL_SetRenderDrawColor(ctx.render, 31, 37, 43, 50);
     SDL_RenderClear(ctx.render);
 
-    auto center_text = [&](std::string const &text, int y, Color const &color)
+    auto center_text = [&](TextBuilder &text, int y)
     {
-        const auto [text_width, text_height] = ctx.res.font.get_text_size(text);
-        const auto text_x = (400 - text_width) / 2;
-        ctx.res.font.builder()
-            .with_pos(text_x, y)
-            .with_color(color)
-            .with_text(text)
-            .draw();
+        const auto [text_width, text_height] = text.get_size();
+        text.with_pos((400 - text_width) / 2, y).draw(ctx.batch);
     };
 
-    center_text("Game Over", 100, Color(255, 255, 255));
+    center_text(ctx.res.font.builder().with_text("Game Over").with_color(Color(255, 255, 255)), 100);
 
-    center_text("Ruby score: " + std::to_string(ruby_score), 150, COLOR_RUBY);
-    center_text("Pearl score: " + std::to_string(pearl_score), 165, COLOR_PEARL);
+    center_text(ctx.res.font.builder().with_format("Ruby score: %d", ruby_score).with_color(COLOR_RUBY), 150);
+    center_text(ctx.res.font.builder().with_format("Pearl score: %d", pearl_score).with_color(COLOR_PEARL), 165);
 
     if (ruby_score > pearl_score)
     {
-        center_text("Ruby wins!", 180, COLOR_RUBY);
+        center_text(ctx.res.font.builder().with_text("Ruby wins!").with_color(COLOR_RUBY), 180);
     }
     else if (pearl_score > ruby_score)
     {
-        center_text("Pearl wins!", 180, COLOR_PEARL);
+        center_text(ctx.res.font.builder().with_text("Pearl wins!").with_color(COLOR_PEARL), 180);
     }
     else
     {
-        center_text("Draw!", 180, Color(255, 255, 0));
+        center_text(ctx.res.font.builder().with_text("Draw!").with_color(Color(255, 255, 0)), 180);
     }
 
     ok_button.draw(ctx);
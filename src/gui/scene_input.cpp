@@ -4,6 +4,11 @@
 
 using namespace hexx::gui;
 
+static bool caret_visible()
+{
+    return SDL_GetTicks() / 500 % 2 == 0;
+}
+
 SceneInput::SceneInput(std::string message, std::function<void(Context &, std::string)> callback) : SceneBase(), message{message}, callback{callback}, pos{}, input{}
 {
     ok_button.set_text("OK");
@@ -24,7 +29,7 @@ void SceneInput::draw(Context &ctx)
     SDL_SetRenderDrawColor(ctx.render, 31, 37, 43, 255);
     SDL_RenderClear(ctx.render);
 
-    auto center_text = [&](std::string const &text, int y, Color const &color)
+    auto center_text = [&](std::string_view text, int y, Color const &color)
     {
         const auto [text_width, text_height] = ctx.res.font.get_text_size(text);
         const auto text_x = (400 - text_width) / 2;
@@ -32,7 +37,7 @@ void SceneInput::draw(Context &ctx)
             .with_pos(text_x, y)
             .with_color(color)
             .with_text(text)
-            .draw();
+            .draw(ctx.batch);
     };
 
     center_text(message, 50, Color(255, 255, 255));
@@ -41,16 +46,27 @@ void SceneInput::draw(Context &ctx)
         .with_pos(40, 100)
         .with_color(Color(255, 255, 255))
         .with_text(input)
-        .draw();
+        .draw(ctx.batch);
 
-    if (SDL_GetTicks() / 500 % 2 == 0)
+    caret_drawn = caret_visible();
+    if (caret_drawn)
     {
-        fill_rect(ctx.render, {40 + ctx.res.font.get_text_size(input.substr(0, pos)).first, 100, 2, 10}, Color(255, 255, 255));
+        fill_rect(ctx.render, {40 + ctx.res.font.get_text_size(std::string_view(input).substr(0, pos)).first, 100, 2, 10}, Color(255, 255, 255));
     }
 
     ok_button.draw(ctx);
 }
 
+bool SceneInput::is_dirty() const
+{
+    return redraw || caret_visible() != caret_drawn;
+}
+
+uint32_t SceneInput::ms_until_dirty() const
+{
+    return 500 - SDL_GetTicks() % 500;
+}
+
 void SceneInput::mouse_down(Context &ctx, uint8_t index, int x, int y)
 {
     ok_button.mouse_down(ctx, x, y);
@@ -19,6 +19,11 @@ namespace hexx::gui
         std::string input;
         unsigned int pos;
 
+        /**
+         * @brief Whether the blinking caret was visible when the scene was last drawn.
+         */
+        bool caret_drawn{false};
+
         std::function<void(Context &, std::string)> callback;
 
     public:
@@ -30,6 +35,18 @@ namespace hexx::gui
 
         void draw(Context &ctx) override;
 
+        /**
+         * @brief Dirty also when the caret blinks.
+         */
+        bool is_dirty() const override;
+
+        uint32_t ms_until_dirty() const override;
+
+        bool is_opaque() const override
+        {
+            return true;
+        }
+
         void mouse_down(Context &ctx, uint8_t index, int x, int y) override;
 
         void mouse_up(Context &ctx, uint8_t index, int x, int y) override;
@@ -53,7 +53,7 @@ SceneMainMenu::SceneMainMenu() : SceneBase()
                     {
                         auto scene = std::make_unique<SceneGame>();
                         auto data = read_file(filename);
-                        scene->board.deserialize(data);
+                        scene->load(data);
                         ctx.manager.replace(std::move(scene));
                     }
                     catch (std::exception &e)
@@ -79,17 +79,15 @@ void SceneMainMenu::tick(Context &ctx)
 
 void SceneMainMenu::draw(Context &ctx)
 {
-    using std::operator""s;
-
     SDL_SetRenderDrawColor(ctx.render, 31, 37, 43, 255);
     SDL_RenderClear(ctx.render);
 
     const auto center = (DISPLAY_WIDTH - (ctx.res.logo_hexx.get_rect().w * 2 + ctx.res.logo_agon.get_rect().w * 2)) / 2;
     const auto logo_pos_y = 30;
 
-    ctx.res.logo_hexx.draw_scaled(center, logo_pos_y,
+    ctx.res.logo_hexx.draw_scaled(ctx.batch, center, logo_pos_y,
                                   ctx.res.logo_hexx.get_rect().w * 2, ctx.res.logo_hexx.get_rect().h * 2);
-    ctx.res.logo_agon.draw_scaled(center + ctx.res.logo_hexx.get_rect().w * 2, logo_pos_y,
+    ctx.res.logo_agon.draw_scaled(ctx.batch, center + ctx.res.logo_hexx.get_rect().w * 2, logo_pos_y,
                                   ctx.res.logo_agon.get_rect().w * 2, ctx.res.logo_agon.get_rect().h * 2);
 
     single_player_button.draw(ctx);
@@ -101,9 +99,8 @@ void SceneMainMenu::draw(Context &ctx)
         .with_text("Press '=' in game to save the game state to file")
         .with_color(Color(255, 255, 255))
         .with_pos(10, DISPLAY_HEIGHT - 20)
-        .draw();
+        .draw(ctx.batch);
 
-    HighScoreManager high_score_manager{};
     if (!high_score_manager.scores.empty())
     {
         // printf("\nHigh scores:\n");
@@ -111,7 +108,7 @@ void SceneMainMenu::draw(Context &ctx)
             .with_text("High scores")
             .with_color(Color(255, 255, 0))
             .with_pos(10, DISPLAY_HEIGHT - 100)
-            .draw();
+            .draw(ctx.batch);
         for (auto i = 0; auto const &score : high_score_manager.scores)
         {
             auto outcome = score.winner == HighScoreManager::Winner::Ruby    ? "Ruby won"
@@ -119,10 +116,10 @@ void SceneMainMenu::draw(Context &ctx)
                                                                              : "Draw";
 
             ctx.res.font.builder()
-                .with_text("Ruby "s + std::to_string(score.ruby) + " - " + std::to_string(score.pearl) + " Pearl, " + outcome)
+                .with_format("Ruby %d - %d Pearl, %s", score.ruby, score.pearl, outcome)
                 .with_color(Color(200, 200, 200))
                 .with_pos(10, DISPLAY_HEIGHT - 90 + i++ * 10)
-                .draw();
+                .draw(ctx.batch);
         }
     }
 }
@@ -2,6 +2,7 @@
 
 #include "scene.h"
 #include "button.h"
+#include <common/highscore_manager.h>
 
 namespace hexx::gui
 {
@@ -17,6 +18,11 @@ namespace hexx::gui
         Button load_button{};
         Button quit_button{};
 
+        /**
+         * @brief Loaded once, the menu is created again after every game.
+         */
+        common::HighScoreManager high_score_manager{};
+
     public:
         SceneMainMenu();
 
@@ -26,6 +32,11 @@ namespace hexx::gui
 
         void draw(Context &ctx) override;
 
+        bool is_opaque() const override
+        {
+            return true;
+        }
+
         void mouse_down(Context &ctx, uint8_t index, int x, int y) override;
 
         void mouse_up(Context &ctx, uint8_t index, int x, int y) override;
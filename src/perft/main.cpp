@@ -0,0 +1,397 @@
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <common/board.h>
+#include <common/files.h>
+#include <common/level_data.h>
+
+using namespace hexx::common;
+
+/**
+ * @brief Settings of a perft run, taken from the command line.
+ */
+struct PerftOptions
+{
+    int depth{4};
+
+    /**
+     * @brief Board::serialize file to start from, LEVEL1_TEMPLATE if empty.
+     */
+    std::string file{};
+
+    /**
+     * @brief Print the leaf count below every root move.
+     */
+    bool divide{false};
+
+    /**
+     * @brief Also count with every move of every gem, see perft_per_origin.
+     */
+    bool per_origin{false};
+
+    /**
+     * @brief Size of the perft cache in megabytes, 0 disables it.
+     */
+    size_t cache_mb{0};
+
+    int threads{1};
+};
+
+/**
+ * @brief Leaf counts of positions already counted, shared by all threads.
+ *
+ * Every entry keeps the count and the key xored with the count, so a torn write by another thread reads as a miss
+ * rather than as a wrong count. Entries are replaced on every store.
+ */
+class PerftCache
+{
+    struct Entry
+    {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> count{0};
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    size_t mask;
+
+    /**
+     * @brief Position hash mixed with the remaining depth, the same position counts differently at every depth.
+     */
+    static uint64_t key_of(uint64_t hash, int depth)
+    {
+        return hash ^ (static_cast<uint64_t>(depth) * 0x9E3779B97F4A7C15ULL);
+    }
+
+public:
+    explicit PerftCache(size_t megabytes)
+    {
+        const auto count = std::bit_floor(std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Entry), 1));
+        entries = std::make_unique<Entry[]>(count);
+        mask = count - 1;
+    }
+
+    std::optional<uint64_t> probe(uint64_t hash, int depth) const
+    {
+        const auto key = key_of(hash, depth);
+        auto const &entry = entries[key & mask];
+
+        const auto count = entry.count.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ count) != key)
+            return std::nullopt;
+
+        return count;
+    }
+
+    void store(uint64_t hash, int depth, uint64_t count)
+    {
+        const auto key = key_of(hash, depth);
+        auto &entry = entries[key & mask];
+
+        entry.check.store(key ^ count, std::memory_order_relaxed);
+        entry.count.store(count, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Counts the positions exactly depth plies below the board. A player without moves passes,
+ * like in Board::next_player, and the pass counts as a ply. Finished games have no children.
+ * Moves come from Board::generate_moves, which generates one clone per destination tile.
+ */
+static uint64_t perft(Board &board, int depth, PerftCache *cache)
+{
+    if (depth == 0)
+        return 1;
+
+    if (board.game_ended())
+        return 0;
+
+    if (cache)
+    {
+        if (const auto count = cache->probe(board.hash(), depth))
+            return *count;
+    }
+
+    MoveList<MAX_MOVES> moves;
+    board.generate_moves(moves);
+
+    uint64_t nodes = 0;
+
+    if (moves.empty())
+    {
+        board.current_player = other_player(board.current_player);
+
+        // neither player can reach an empty tile, the game is stuck and ends here
+        if (board.any_move())
+            nodes = perft(board, depth - 1, cache);
+
+        board.current_player = other_player(board.current_player);
+    }
+    else if (depth == 1)
+    {
+        // every move leads to exactly one leaf, no need to play them
+        nodes = moves.size();
+    }
+    else
+    {
+        for (const auto &move : moves)
+        {
+            const auto record = board.make_move(move.from, move.to);
+            nodes += perft(board, depth - 1, cache);
+            board.unmake_move(record);
+        }
+    }
+
+    if (cache)
+        cache->store(board.hash(), depth, nodes);
+
+    return nodes;
+}
+
+/**
+ * @brief Counts like perft, but with the moves of every gem as Board::get_possible_moves lists them, so clones
+ * into the same tile from different gems are counted separately. No cache, it's only a cross-check.
+ */
+static uint64_t perft_per_origin(Board &board, int depth)
+{
+    if (depth == 0)
+        return 1;
+
+    if (board.game_ended())
+        return 0;
+
+    if (!board.any_move())
+    {
+        board.current_player = other_player(board.current_player);
+
+        uint64_t nodes = 0;
+        if (board.any_move())
+            nodes = perft_per_origin(board, depth - 1);
+
+        board.current_player = other_player(board.current_player);
+        return nodes;
+    }
+
+    uint64_t nodes = 0;
+    MoveList<MAX_MOVES_PER_TILE> moves;
+
+    auto sources = board.tiles_of(board.current_player);
+    while (sources.any())
+    {
+        board.generate_moves(sources.pop_lowest(), moves);
+
+        for (const auto &move : moves)
+        {
+            const auto record = board.make_move(move.from, move.to);
+            nodes += perft_per_origin(board, depth - 1);
+            board.unmake_move(record);
+        }
+    }
+
+    return nodes;
+}
+
+/**
+ * @brief Splits the root moves between the threads and counts the leaves below each of them.
+ *
+ * @return std::vector<uint64_t> leaf count of every root move, in the order of moves
+ */
+static std::vector<uint64_t> perft_root(Board const &board, MoveList<MAX_MOVES> const &moves, PerftOptions const &options, PerftCache *cache)
+{
+    std::vector<uint64_t> counts(moves.size());
+    std::atomic<size_t> next{0};
+
+    const auto worker = [&]()
+    {
+        Board position = board;
+
+        for (auto i = next.fetch_add(1); i < moves.size(); i = next.fetch_add(1))
+        {
+            const auto record = position.make_move(moves[i].from, moves[i].to);
+            counts[i] = perft(position, options.depth - 1, cache);
+            position.unmake_move(record);
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < options.threads; i++)
+    {
+        helpers.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto &helper : helpers)
+    {
+        helper.join();
+    }
+
+    return counts;
+}
+
+static Board load_board(PerftOptions const &options)
+{
+    Board board;
+
+    if (options.file.empty())
+        board.reset(HexMap<TileState>{LEVEL1_TEMPLATE});
+    else
+        board.deserialize(read_file(options.file));
+
+    return board;
+}
+
+static constexpr int MAX_DEPTH = 64;
+static constexpr int MAX_THREADS = 1024;
+
+/**
+ * @brief Largest cache accepted, its size in bytes can't overflow a size_t.
+ */
+static constexpr size_t MAX_CACHE_MB = 1024 * 1024;
+
+/**
+ * @brief Parses a whole number argument.
+ *
+ * @return bool false if the argument isn't a number from min to max
+ */
+template <typename T>
+static bool parse_number(char const *text, long long min, long long max, T &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    const auto number = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || number < min || number > max)
+        return false;
+
+    value = static_cast<T>(number);
+    return true;
+}
+
+static void print_usage(char const *program)
+{
+    printf("Usage: %s [-d] [-o] [-t threads] [-c megabytes] [-f file] [depth]\n", program);
+    printf("Counts positions reached by distinct moves: clones into a tile from different gems count once.\n");
+    printf("  -d            print the leaf count below every root move\n");
+    printf("  -o            also count every move of every gem, clones from different gems separately\n");
+    printf("  -t threads    split the root moves between threads, up to %d, default 1, 0 for every core\n", MAX_THREADS);
+    printf("  -c megabytes  cache counts of positions already seen, up to %zu, default 0 (off)\n", MAX_CACHE_MB);
+    printf("  -f file       start from a saved game instead of the first level\n");
+    printf("  depth         plies to count, 1 to %d, default 4\n", MAX_DEPTH);
+}
+
+int main(int argc, char **argv)
+{
+    PerftOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const auto has_value = i + 1 < argc;
+        auto valid = true;
+
+        if (arg == "-d")
+            options.divide = true;
+        else if (arg == "-o")
+            options.per_origin = true;
+        else if (arg == "-t" && has_value)
+            valid = parse_number(argv[++i], 0, MAX_THREADS, options.threads);
+        else if (arg == "-c" && has_value)
+            valid = parse_number(argv[++i], 0, MAX_CACHE_MB, options.cache_mb);
+        else if (arg == "-f" && has_value)
+            options.file = argv[++i];
+        else if (arg[0] != '-')
+            valid = parse_number(arg.c_str(), 1, MAX_DEPTH, options.depth);
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.threads == 0)
+        options.threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+
+    Board board;
+    try
+    {
+        board = load_board(options);
+    }
+    catch (std::exception const &e)
+    {
+        printf("Error loading '%s': %s\n", options.file.c_str(), e.what());
+        return 1;
+    }
+
+    std::unique_ptr<PerftCache> cache;
+    try
+    {
+        if (options.cache_mb > 0)
+            cache = std::make_unique<PerftCache>(options.cache_mb);
+    }
+    catch (std::bad_alloc const &)
+    {
+        printf("Can't allocate a cache of %zu MB\n", options.cache_mb);
+        return 1;
+    }
+
+    MoveList<MAX_MOVES> moves;
+    board.generate_moves(moves);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    uint64_t nodes = 0;
+    std::vector<uint64_t> counts;
+
+    if (moves.empty() || board.game_ended())
+    {
+        // nothing to split, a pass or a finished game
+        nodes = perft(board, options.depth, cache.get());
+    }
+    else
+    {
+        counts = perft_root(board, moves, options, cache.get());
+
+        for (const auto count : counts)
+        {
+            nodes += count;
+        }
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (options.divide)
+    {
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            const auto move = board.move_info(moves[i]);
+            printf("{%d, %d} -> {%d, %d}: %llu\n", move.from.first, move.from.second, move.to.first, move.to.second,
+                   static_cast<unsigned long long>(counts[i]));
+        }
+        printf("\n");
+    }
+
+    printf("Depth %d: %llu nodes in %.3f s, %.0f nodes/s\n", options.depth, static_cast<unsigned long long>(nodes), elapsed,
+           elapsed > 0 ? nodes / elapsed : 0.0);
+
+    if (options.per_origin)
+    {
+        const auto per_origin = perft_per_origin(board, options.depth);
+        printf("Depth %d: %llu nodes counting every origin, %llu more than distinct moves\n", options.depth,
+               static_cast<unsigned long long>(per_origin), static_cast<unsigned long long>(per_origin - nodes));
+    }
+
+    return 0;
+}
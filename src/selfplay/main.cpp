@@ -0,0 +1,629 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <common/board.h>
+#include <common/byte_utils.h>
+#include <common/files.h>
+#include <common/level_data.h>
+#include <common/mcts.h>
+#include <common/search.h>
+
+using namespace hexx::common;
+
+/**
+ * @brief Settings of one of the two engines, parsed from "search:depth=4,time=50" or "mcts:playouts=2000".
+ */
+struct EngineSpec
+{
+    enum class Kind
+    {
+        Search,
+        Mcts,
+    };
+
+    std::string text{};
+    Kind kind{Kind::Search};
+    SearchLimits search_limits{};
+    MctsLimits mcts_limits{.playouts = 2000};
+
+    /**
+     * @brief Transposition table size of a search engine in megabytes, 0 for none.
+     */
+    size_t hash_mb{16};
+
+    /**
+     * @brief Node pool of an MCTS engine.
+     */
+    size_t pool{1 << 18};
+
+    double exploration{1.0};
+
+    /**
+     * @throws invalid_argument if the text isn't a valid engine.
+     */
+    static EngineSpec parse(std::string const &text)
+    {
+        EngineSpec spec;
+        spec.text = text;
+
+        const auto colon = text.find(':');
+        const auto kind = text.substr(0, colon);
+
+        if (kind == "search")
+            spec.kind = Kind::Search;
+        else if (kind == "mcts")
+            spec.kind = Kind::Mcts;
+        else
+            throw std::invalid_argument("unknown engine '" + kind + "'");
+
+        auto rest = colon == std::string::npos ? std::string{} : text.substr(colon + 1);
+
+        while (!rest.empty())
+        {
+            const auto comma = rest.find(',');
+            const auto option = rest.substr(0, comma);
+            rest = comma == std::string::npos ? std::string{} : rest.substr(comma + 1);
+
+            const auto equals = option.find('=');
+            if (equals == std::string::npos)
+                throw std::invalid_argument("expected key=value, got '" + option + "'");
+
+            const auto key = option.substr(0, equals);
+            const auto value = option.substr(equals + 1);
+
+            if (spec.kind == Kind::Search && key == "depth")
+                spec.search_limits.depth = std::clamp(std::atoi(value.c_str()), 1, MAX_PLY);
+            else if (spec.kind == Kind::Search && key == "nodes")
+                spec.search_limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+            else if (spec.kind == Kind::Search && key == "time")
+                spec.search_limits.time = std::chrono::milliseconds{std::atoi(value.c_str())};
+            else if (spec.kind == Kind::Search && key == "hash")
+                spec.hash_mb = std::strtoull(value.c_str(), nullptr, 10);
+            else if (spec.kind == Kind::Mcts && key == "playouts")
+                spec.mcts_limits.playouts = std::strtoull(value.c_str(), nullptr, 10);
+            else if (spec.kind == Kind::Mcts && key == "time")
+                spec.mcts_limits.time = std::chrono::milliseconds{std::atoi(value.c_str())};
+            else if (spec.kind == Kind::Mcts && key == "pool")
+                spec.pool = std::strtoull(value.c_str(), nullptr, 10);
+            else if (spec.kind == Kind::Mcts && key == "c")
+                spec.exploration = std::atof(value.c_str());
+            else
+                throw std::invalid_argument("unknown option '" + key + "' of engine '" + kind + "'");
+        }
+
+        if (spec.kind == Kind::Mcts && spec.mcts_limits.playouts == 0 && spec.mcts_limits.time.count() == 0)
+            throw std::invalid_argument("mcts needs a playout or time limit");
+
+        return spec;
+    }
+};
+
+/**
+ * @brief An engine of one worker thread, single-threaded so that every core plays its own game.
+ */
+class Engine
+{
+    EngineSpec const &spec;
+    Search search;
+    std::shared_ptr<TranspositionTable> table;
+    std::unique_ptr<Mcts> mcts;
+
+public:
+    explicit Engine(EngineSpec const &spec) : spec(spec)
+    {
+        if (spec.kind == EngineSpec::Kind::Search)
+        {
+            if (spec.hash_mb > 0)
+            {
+                table = std::make_shared<TranspositionTable>(spec.hash_mb);
+                search.set_transposition_table(table);
+            }
+        }
+        else
+        {
+            mcts = std::make_unique<Mcts>(spec.pool);
+            mcts->set_exploration(spec.exploration);
+        }
+    }
+
+    /**
+     * @brief Forgets the previous game, so results don't depend on which games a worker played before.
+     */
+    void new_game()
+    {
+        if (table)
+            table->clear();
+    }
+
+    Move choose(Board const &board)
+    {
+        if (mcts)
+            return mcts->run(board, spec.mcts_limits).best_move;
+
+        if (table)
+            table->new_search();
+
+        return search.run(board, spec.search_limits).best_move;
+    }
+};
+
+/**
+ * @brief Settings of a tournament, taken from the command line.
+ */
+struct SelfPlayOptions
+{
+    EngineSpec engine_a{EngineSpec::parse("search:depth=3")};
+    EngineSpec engine_b{EngineSpec::parse("search:depth=2")};
+    int games{1000};
+    int threads{0};
+
+    /**
+     * @brief Random plies played from the start position before the engines take over. Both games of a pair
+     * start from the same opening with colours swapped.
+     */
+    int opening_plies{4};
+
+    /**
+     * @brief Games still going after this many plies are scored by their gem count.
+     */
+    int max_plies{400};
+
+    uint64_t seed{1};
+
+    /**
+     * @brief Game records file, none if empty.
+     */
+    std::string output{};
+
+    bool sprt{false};
+    double elo0{0.0};
+    double elo1{10.0};
+    double alpha{0.05};
+    double beta{0.05};
+};
+
+/**
+ * @brief A finished game. Moves include the random opening, passes are PASS_MOVE.
+ */
+struct GameRecord
+{
+    uint32_t index{0};
+    bool a_is_ruby{true};
+    uint8_t opening_plies{0};
+
+    /**
+     * @brief Ruby's gems minus Pearl's at the end.
+     */
+    int margin{0};
+
+    std::vector<Move> moves{};
+};
+
+static constexpr Move PASS_MOVE = Mcts::PASS_MOVE;
+
+/**
+ * @brief Wins, draws and losses of engine A, with the statistics derived from them.
+ */
+struct Tally
+{
+    int wins{0};
+    int draws{0};
+    int losses{0};
+
+    int games() const
+    {
+        return wins + draws + losses;
+    }
+
+    double score() const
+    {
+        return games() > 0 ? (wins + 0.5 * draws) / games() : 0.5;
+    }
+
+    /**
+     * @brief Variance of the result of a single game. It's kept at least at what a single game ending half
+     * a point differently would add, so a run of identical results doesn't read as a certain one.
+     */
+    double variance() const
+    {
+        if (games() == 0)
+            return 0.0;
+
+        const auto s = score();
+        const auto variance = (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+        return std::max(variance, 0.25 / games());
+    }
+
+    static double elo_of(double score)
+    {
+        score = std::clamp(score, 0.001, 0.999);
+        return -400.0 * std::log10(1.0 / score - 1.0);
+    }
+
+    static double score_of(double elo)
+    {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+
+    double elo() const
+    {
+        return elo_of(score());
+    }
+
+    /**
+     * @brief Half the width of the 95% confidence interval of elo().
+     */
+    double elo_error() const
+    {
+        if (games() == 0)
+            return 0.0;
+
+        const auto margin = 1.96 * std::sqrt(variance() / games());
+        return (elo_of(score() + margin) - elo_of(score() - margin)) / 2.0;
+    }
+
+    /**
+     * @brief Log-likelihood ratio of elo1 against elo0, in the normal approximation of the game results.
+     */
+    double llr(double elo0, double elo1) const
+    {
+        const auto var = variance();
+        if (var <= 0.0)
+            return 0.0;
+
+        const auto s0 = score_of(elo0);
+        const auto s1 = score_of(elo1);
+        return games() * (s1 - s0) * (2.0 * score() - s0 - s1) / (2.0 * var);
+    }
+};
+
+/**
+ * @brief Plays a move and handles passes the way Board::next_player does.
+ *
+ * @return bool true if the game goes on
+ */
+static bool play(Board &board, Move const &move, GameRecord &record)
+{
+    board.make_move(move.from, move.to);
+    record.moves.push_back(move);
+
+    if (board.game_ended())
+        return false;
+
+    if (board.any_move())
+        return true;
+
+    // the opponent passes, unless neither side can reach an empty tile any more
+    board.current_player = other_player(board.current_player);
+    if (!board.any_move())
+        return false;
+
+    record.moves.push_back(PASS_MOVE);
+    return true;
+}
+
+static GameRecord play_game(uint32_t index, SelfPlayOptions const &options, Engine &engine_a, Engine &engine_b)
+{
+    GameRecord record{.index = index, .a_is_ruby = index % 2 == 0};
+
+    Board board;
+    board.reset(HexMap<TileState>{LEVEL1_TEMPLATE});
+
+    engine_a.new_game();
+    engine_b.new_game();
+
+    // both games of a pair draw the same opening
+    std::mt19937_64 gen{options.seed * 0x9E3779B97F4A7C15ULL + index / 2};
+    bool running = !board.game_ended() && board.any_move();
+
+    for (int ply = 0; running && ply < options.opening_plies; ply++)
+    {
+        MoveList<MAX_MOVES> moves;
+        board.generate_moves(moves);
+
+        running = play(board, moves[gen() % moves.size()], record);
+        record.opening_plies++;
+    }
+
+    while (running && static_cast<int>(record.moves.size()) < options.max_plies)
+    {
+        auto &engine = (board.current_player == Player::Ruby) == record.a_is_ruby ? engine_a : engine_b;
+        running = play(board, engine.choose(board), record);
+    }
+
+    record.margin = static_cast<int>(board.ruby_score) - static_cast<int>(board.pearl_score);
+    return record;
+}
+
+/**
+ * @brief Serializes the games, sorted by index, into a compact binary file, all little-endian:
+ *
+ * - header: magic (u32), version (u16), engine A (string), engine B (string), game count (u32)
+ * - game: index (u32), flags (u8, bit 0 set if A played Ruby), opening plies (u8), Ruby minus Pearl gems (i16),
+ *   move count (u16), moves (origin u8, destination u8, 0xFF 0xFF for a pass)
+ */
+static std::vector<uint8_t> serialize_games(SelfPlayOptions const &options, std::vector<GameRecord> games)
+{
+    std::ranges::sort(games, {}, &GameRecord::index);
+
+    ByteWriter writer;
+    writer.write_uint32(0x26306B01);
+    writer.write_uint16(1);
+    writer.write_string(options.engine_a.text);
+    writer.write_string(options.engine_b.text);
+    writer.write_uint32(games.size());
+
+    for (const auto &game : games)
+    {
+        writer.write_uint32(game.index);
+        writer.write_uint8(game.a_is_ruby ? 1 : 0);
+        writer.write_uint8(game.opening_plies);
+        writer.write_int16(game.margin);
+        writer.write_uint16(game.moves.size());
+
+        for (const auto &move : game.moves)
+        {
+            writer.write_uint8(move.from);
+            writer.write_uint8(move.to);
+        }
+    }
+
+    return std::move(writer.data);
+}
+
+/**
+ * @brief Runs the tournament on a pool of worker threads, each playing one game at a time.
+ */
+class Tournament
+{
+    SelfPlayOptions const &options;
+
+    std::atomic<int> next_game{0};
+    std::atomic<bool> stop{false};
+
+    std::mutex mutex;
+    Tally tally;
+    std::vector<GameRecord> records;
+    char const *verdict{nullptr};
+    std::chrono::steady_clock::time_point start_time;
+
+    /**
+     * @brief First exception thrown by a worker, rethrown by run() once every worker stopped.
+     */
+    std::exception_ptr error{nullptr};
+
+    void finish_game(GameRecord &&record)
+    {
+        std::lock_guard lock{mutex};
+
+        const auto a_margin = record.a_is_ruby ? record.margin : -record.margin;
+        if (a_margin > 0)
+            tally.wins++;
+        else if (a_margin < 0)
+            tally.losses++;
+        else
+            tally.draws++;
+
+        if (!options.output.empty())
+            records.push_back(std::move(record));
+
+        printf("\rGames %d: +%d =%d -%d, Elo %+.1f +- %.1f", tally.games(), tally.wins, tally.draws, tally.losses,
+               tally.elo(), tally.elo_error());
+
+        if (options.sprt && !verdict)
+        {
+            const auto llr = tally.llr(options.elo0, options.elo1);
+            printf(", LLR %.2f [%.2f, %.2f]", llr, lower_bound(), upper_bound());
+
+            if (llr >= upper_bound())
+                verdict = "H1 accepted";
+            else if (llr <= lower_bound())
+                verdict = "H0 accepted";
+
+            // games already being played are finished and counted, no new ones start
+            if (verdict)
+                stop.store(true);
+        }
+
+        printf("   ");
+        fflush(stdout);
+    }
+
+    void worker()
+    {
+        try
+        {
+            Engine engine_a{options.engine_a};
+            Engine engine_b{options.engine_b};
+
+            while (!stop.load())
+            {
+                const auto index = next_game.fetch_add(1);
+                if (index >= options.games)
+                    break;
+
+                finish_game(play_game(index, options, engine_a, engine_b));
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard lock{mutex};
+            if (!error)
+                error = std::current_exception();
+
+            stop.store(true);
+        }
+    }
+
+    double lower_bound() const
+    {
+        return std::log(options.beta / (1.0 - options.alpha));
+    }
+
+    double upper_bound() const
+    {
+        return std::log((1.0 - options.beta) / options.alpha);
+    }
+
+public:
+    explicit Tournament(SelfPlayOptions const &options) : options(options) {}
+
+    void run()
+    {
+        const auto threads = options.threads > 0 ? options.threads : std::max<int>(std::thread::hardware_concurrency(), 1);
+
+        printf("%s vs %s, %d games on %d threads\n", options.engine_a.text.c_str(), options.engine_b.text.c_str(),
+               options.games, threads);
+
+        start_time = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++)
+        {
+            workers.emplace_back(&Tournament::worker, this);
+        }
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+
+        const auto hours = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() / 3600.0;
+
+        printf("\n\nScore of %s vs %s: +%d =%d -%d (%.1f%%)\n", options.engine_a.text.c_str(), options.engine_b.text.c_str(),
+               tally.wins, tally.draws, tally.losses, tally.score() * 100.0);
+        printf("Elo difference: %+.1f +- %.1f (95%%)\n", tally.elo(), tally.elo_error());
+
+        if (options.sprt)
+        {
+            printf("SPRT elo0 %.1f elo1 %.1f: LLR %.2f, %s\n", options.elo0, options.elo1, tally.llr(options.elo0, options.elo1),
+                   verdict ? verdict : "no decision");
+        }
+
+        printf("%.0f games per hour\n", hours > 0 ? tally.games() / hours : 0.0);
+
+        if (!options.output.empty())
+        {
+            write_file(options.output, serialize_games(options, std::move(records)));
+            printf("Wrote %d game records to '%s'.\n", tally.games(), options.output.c_str());
+        }
+    }
+};
+
+/**
+ * @brief Longest opening a game record holds, its opening plies are a u8.
+ */
+static constexpr int MAX_OPENING_PLIES = UINT8_MAX;
+
+/**
+ * @brief Longest game a game record holds, its move count is a u16 and the last move may be followed by a pass.
+ */
+static constexpr int MAX_GAME_PLIES = UINT16_MAX - 1;
+
+/**
+ * @return bool true if the argument is a whole number from min to max.
+ */
+static bool in_range(std::string const &value, int min, int max)
+{
+    char *end = nullptr;
+    const auto number = std::strtol(value.c_str(), &end, 10);
+    return !value.empty() && *end == '\0' && number >= min && number <= max;
+}
+
+static void print_usage(char const *program)
+{
+    printf("Usage: %s [-a engine] [-b engine] [-n games] [-t threads] [-r plies] [-m plies] [-z seed] [-s elo0,elo1] [-o file]\n", program);
+    printf("  -a engine     engine A, default search:depth=3\n");
+    printf("  -b engine     engine B, default search:depth=2\n");
+    printf("  -n games      number of games, default 1000, A plays Ruby in even games\n");
+    printf("  -t threads    worker threads, default every core\n");
+    printf("  -r plies      random opening plies, shared by each pair of games, 0 to 255, default 4\n");
+    printf("  -m plies      games longer than this are scored by gem count, 1 to 65534, default 400\n");
+    printf("  -z seed       seed of the random openings, default 1\n");
+    printf("  -s elo0,elo1  stop early once SPRT accepts one of the hypotheses, alpha = beta = 0.05\n");
+    printf("  -o file       write compact game records\n");
+    printf("\n");
+    printf("Engines: search[:depth=N,nodes=N,time=MS,hash=MB] or mcts[:playouts=N,time=MS,pool=NODES,c=EXPLORATION]\n");
+}
+
+int main(int argc, char **argv)
+{
+    SelfPlayOptions options;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+
+            if (i + 1 >= argc)
+            {
+                print_usage(argv[0]);
+                return 1;
+            }
+
+            const std::string value = argv[++i];
+
+            if (arg == "-a")
+                options.engine_a = EngineSpec::parse(value);
+            else if (arg == "-b")
+                options.engine_b = EngineSpec::parse(value);
+            else if (arg == "-n")
+                options.games = std::atoi(value.c_str());
+            else if (arg == "-t")
+                options.threads = std::atoi(value.c_str());
+            else if (arg == "-r" && in_range(value, 0, MAX_OPENING_PLIES))
+                options.opening_plies = std::atoi(value.c_str());
+            else if (arg == "-m" && in_range(value, 1, MAX_GAME_PLIES))
+                options.max_plies = std::atoi(value.c_str());
+            else if (arg == "-z")
+                options.seed = std::strtoull(value.c_str(), nullptr, 10);
+            else if (arg == "-o")
+                options.output = value;
+            else if (arg == "-s" && std::sscanf(value.c_str(), "%lf,%lf", &options.elo0, &options.elo1) == 2)
+                options.sprt = true;
+            else
+            {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+
+        // engines the workers can't build are reported here rather than from a thread
+        Engine{options.engine_a};
+        Engine{options.engine_b};
+    }
+    catch (std::exception const &e)
+    {
+        printf("Invalid engine: %s\n", e.what());
+        return 1;
+    }
+
+    try
+    {
+        Tournament{options}.run();
+    }
+    catch (std::exception const &e)
+    {
+        printf("\nError: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}